@@ -0,0 +1,148 @@
+// Functions to store neighbor lists in a compressed form, for graphs
+// whose CSR arrays (4 bytes per arc, 4 or 8 per vertex) do not fit in memory
+//
+// The list of vertex i is stored as its degree, followed by the difference
+// between each neighbor and the one before it (between the first neighbor
+// and i), zigzag-coded so that small negative differences are small too.
+// Every number is a varint: 7 bits per byte, low bits first, the high bit
+// set in all but the last byte.  Lists keep the order of the CSR arrays;
+// sorted lists, and graphs numbered so that neighbors are close (e.g. with
+// --reorder rcm), need one or two bytes per arc.
+//
+// The lists are stored one after the other, and the offset of every
+// ADJPACK_BLOCK-th list is kept in an index; a list is found by skipping
+// the lists before it in its block.  A lattice-like graph takes 6 to 8
+// bytes per vertex in all, against 20 for the CSR arrays.
+//
+// Function calls:
+//   ADJPACK *adjpack_build(int n, const ARC *start, const int *adj)
+//     -- Packs the lists of the CSR arrays: the neighbors of vertex i are
+//        adj[start[i]] ... adj[start[i+1]-1].  Returns NULL if out of
+//        memory.  The arrays can be freed afterwards.
+//   int adjpack_begin(const ADJPACK *g, int i, ADJPACK_ITER *it)
+//   int adjpack_next(ADJPACK_ITER *it, int *v)
+//     -- Decode the neighbors of i, in the order of the CSR arrays:
+//        adjpack_begin() returns the degree of i, and every call of
+//        adjpack_next() stores the next neighbor in *v and returns 1, or
+//        returns 0 after the last one.  (Inline, in adjpack.h.)
+//   int adjpack_degree(const ADJPACK *g, int i)
+//     -- Returns the degree of i.  (Inline, in adjpack.h.)
+//   const unsigned char *adjpack_list(const ADJPACK *g, int i)
+//     -- Returns the start of the packed list of i.
+//   size_t adjpack_size(const ADJPACK *g)
+//     -- Returns the bytes taken by the packed lists and their index.
+//   void adjpack_free(ADJPACK *g)
+//     -- Frees the packed lists.
+
+
+// Inclusions
+
+#include <stdlib.h>
+
+#include "adjpack.h"
+
+
+// Function to store v as a varint at p (if p is not NULL); returns its bytes
+
+static int put_varint(unsigned char *p, unsigned int v)
+{
+  int n=0;
+
+  while (v>=0x80) {
+    if (p!=NULL) p[n] = (unsigned char)(v | 0x80);
+    v >>= 7;
+    n++;
+  }
+  if (p!=NULL) p[n] = (unsigned char)v;
+  return n+1;
+}
+
+
+// Function to pack the list of vertex i at p (or only to count its bytes,
+// for p NULL); returns its bytes
+
+static size_t put_list(unsigned char *p, int i, const ARC *start,
+                       const int *adj)
+{
+  size_t n;
+  int prev=i,d;
+  ARC k;
+
+  n = put_varint(p,(unsigned int)(start[i+1]-start[i]));
+  for (k=start[i]; k<start[i+1]; k++) {
+    d = adj[k] - prev;
+    n += put_varint((p!=NULL) ? p+n : NULL,
+                    ((unsigned int)d << 1) ^ (unsigned int)(d >> 31));
+    prev = adj[k];
+  }
+  return n;
+}
+
+
+ADJPACK *adjpack_build(int n, const ARC *start, const int *adj)
+{
+  ADJPACK *g;
+  size_t bytes=0;
+  int i,blocks;
+
+  g = malloc(sizeof(ADJPACK));
+  if (g==NULL) return NULL;
+  blocks = (n + ADJPACK_BLOCK - 1)/ADJPACK_BLOCK;
+  g->n = n;
+  g->arcs = start[n];
+  g->maxdegree = 0;
+  g->index = malloc(sizeof(long long)*(blocks>0 ? blocks : 1));
+  if (g->index==NULL) {
+    free(g);
+    return NULL;
+  }
+
+  // First the sizes, then the lists
+  for (i=0; i<n; i++) {
+    if (i%ADJPACK_BLOCK==0) g->index[i/ADJPACK_BLOCK] = (long long)bytes;
+    bytes += put_list(NULL,i,start,adj);
+    if (start[i+1]-start[i]>g->maxdegree)
+      g->maxdegree = (int)(start[i+1]-start[i]);
+  }
+  g->bytes = bytes;
+  g->data = malloc(bytes>0 ? bytes : 1);
+  if (g->data==NULL) {
+    free(g->index);
+    free(g);
+    return NULL;
+  }
+  bytes = 0;
+  for (i=0; i<n; i++) bytes += put_list(g->data+bytes,i,start,adj);
+  return g;
+}
+
+
+const unsigned char *adjpack_list(const ADJPACK *g, int i)
+{
+  const unsigned char *p;
+  unsigned int m;
+  int j;
+
+  p = g->data + g->index[i/ADJPACK_BLOCK];
+  for (j=i-i%ADJPACK_BLOCK; j<i; j++) {
+    m = adjpack_varint(&p);
+    while (m>0) {
+      if (!(*p++ & 0x80)) m--;
+    }
+  }
+  return p;
+}
+
+
+size_t adjpack_size(const ADJPACK *g)
+{
+  return g->bytes + sizeof(long long)*((g->n + ADJPACK_BLOCK - 1)/ADJPACK_BLOCK);
+}
+
+
+void adjpack_free(ADJPACK *g)
+{
+  free(g->index);
+  free(g->data);
+  free(g);
+}
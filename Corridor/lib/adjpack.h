@@ -0,0 +1,77 @@
+// Header file for neighbor lists packed as variable-length deltas
+
+#ifndef _ADJPACK_H
+#define _ADJPACK_H
+
+#include <stddef.h>
+
+#include "graphutil.h"
+
+#define ADJPACK_BLOCK 8            // Vertices per entry of the index
+
+typedef struct {
+  int n;
+  long long arcs;
+  int maxdegree;
+  long long *index;                // index[b] is the offset of the list of
+                                   // vertex b*ADJPACK_BLOCK in data
+  unsigned char *data;
+  size_t bytes;                    // Bytes of data
+} ADJPACK;
+
+typedef struct {
+  const unsigned char *p;          // Next byte to decode
+  int left;                        // Neighbors not decoded yet
+  int prev;                        // Last neighbor (first: the vertex)
+} ADJPACK_ITER;
+
+ADJPACK *adjpack_build(int n, const ARC *start, const int *adj);
+const unsigned char *adjpack_list(const ADJPACK *g, int i);
+size_t adjpack_size(const ADJPACK *g);
+void adjpack_free(ADJPACK *g);
+
+
+// Decoding is inlined, as it runs once per arc
+
+static inline unsigned int adjpack_varint(const unsigned char **p)
+{
+  const unsigned char *q=*p;
+  unsigned int v=*q & 0x7f;
+  int shift=7;
+
+  while (*q++ & 0x80) {
+    v |= (unsigned int)(*q & 0x7f) << shift;
+    shift += 7;
+  }
+  *p = q;
+  return v;
+}
+
+static inline int adjpack_begin(const ADJPACK *g, int i, ADJPACK_ITER *it)
+{
+  it->p = adjpack_list(g,i);
+  it->left = (int)adjpack_varint(&it->p);
+  it->prev = i;
+  return it->left;
+}
+
+static inline int adjpack_next(ADJPACK_ITER *it, int *v)
+{
+  unsigned int z;
+
+  if (it->left==0) return 0;
+  it->left--;
+  z = adjpack_varint(&it->p);
+  it->prev += (int)(z >> 1) ^ -(int)(z & 1);
+  *v = it->prev;
+  return 1;
+}
+
+static inline int adjpack_degree(const ADJPACK *g, int i)
+{
+  const unsigned char *p=adjpack_list(g,i);
+
+  return (int)adjpack_varint(&p);
+}
+
+#endif
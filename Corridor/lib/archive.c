@@ -0,0 +1,293 @@
+// Functions to write and read single-file archives of .cor instances
+//
+// An archive holds the .cor files of a batch (or of one shard of it) one
+// after the other, so that a large distribution is one file instead of
+// one file per instance.  All numbers are 64-bit little-endian:
+//
+//   magic "corarch1"
+//   the .cor files, in the order of their instance indices
+//   index: per instance, its index, seed, hash, offset and length
+//   the params of the batch (as in a manifest), not NUL-terminated
+//   trailer: offset of the index, number of entries, instances, masterseed,
+//            shard, shards, length of the params, magic "coraidx1"
+//
+// The trailer has a fixed size, so a reader finds the index from the end
+// of the file, and any instance from the index in constant time.  The
+// reader maps the archive into memory and returns pointers into it.
+//
+// Function calls:
+//   int archive_begin(int fd)
+//     -- Writes the header to fd, which must be at the start of an empty
+//        file.  The .cor files must then be written to fd one after the
+//        other.  Returns 0, or 1 if the write fails.
+//   int archive_end(int fd, const ARCHIVE_INFO *info,
+//                   const ARCHIVE_ENTRY_INFO *entries, long long count)
+//     -- Writes the index of the "count" files and the trailer.  Returns 0,
+//        or 1 if the write fails.
+//   ARCHIVE *archive_open(const char *filename)
+//     -- Maps the archive "filename" into memory.  Returns NULL if it
+//        cannot be read or is not an archive.
+//   long long archive_count(ARCHIVE *a)
+//     -- Returns the number of instances in the archive.
+//   void archive_info(ARCHIVE *a, ARCHIVE_INFO *info)
+//     -- Fills in the batch information; info->params points into the
+//        archive.
+//   int archive_entry(ARCHIVE *a, long long k, ARCHIVE_ENTRY_INFO *entry)
+//     -- Fills in entry k (0 <= k < count) of the index.  Returns 0, or 1
+//        if k is out of range or the entry points outside the archive.
+//   long long archive_find(ARCHIVE *a, unsigned long long index)
+//     -- Returns the entry of the instance with the given index, or -1.
+//   const char *archive_data(ARCHIVE *a, long long k, size_t *length)
+//     -- Returns the .cor file of entry k and sets *length to its size, or
+//        returns NULL as archive_entry() fails.
+//   void archive_close(ARCHIVE *a)
+//     -- Unmaps the archive.
+
+
+// Inclusions
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "archive.h"
+
+// Constants
+
+#define MAGIC       "corarch1"
+#define INDEX_MAGIC "coraidx1"
+
+// Types
+
+struct ARCHIVE {
+  const unsigned char *map;
+  size_t size;
+  unsigned long long indexoffset;
+  long long count;
+  ARCHIVE_INFO info;
+};
+
+
+// Functions to store and load little-endian 64-bit numbers
+
+static void put64(unsigned char *p, unsigned long long v)
+{
+  int k;
+
+  for (k=0; k<8; k++) {
+    p[k] = (unsigned char)(v & 0xff);
+    v >>= 8;
+  }
+}
+
+static unsigned long long get64(const unsigned char *p)
+{
+  unsigned long long v=0;
+  int k;
+
+  for (k=7; k>=0; k--) v = (v << 8) | p[k];
+  return v;
+}
+
+
+// Function to write n bytes, retrying short writes
+
+static int write_all(int fd, const unsigned char *p, size_t n)
+{
+  ssize_t done;
+
+  while (n>0) {
+    done = write(fd,p,n);
+    if (done<0) {
+      if (errno==EINTR) continue;
+      return 1;
+    }
+    p += done;
+    n -= done;
+  }
+  return 0;
+}
+
+
+int archive_begin(int fd)
+{
+  return write_all(fd,(const unsigned char *)MAGIC,8);
+}
+
+
+int archive_end(int fd, const ARCHIVE_INFO *info,
+                const ARCHIVE_ENTRY_INFO *entries, long long count)
+{
+  unsigned char *buf,*p;
+  size_t size;
+  off_t indexoffset;
+  long long k;
+  int result;
+
+  indexoffset = lseek(fd,0,SEEK_CUR);
+  if (indexoffset<0) return 1;
+
+  size = (size_t)count*ARCHIVE_ENTRY + info->paramslength + ARCHIVE_TRAILER;
+  buf = malloc(size);
+  if (buf==NULL) return 1;
+
+  p = buf;
+  for (k=0; k<count; k++) {
+    put64(p,entries[k].index);
+    put64(p+8,entries[k].seed);
+    put64(p+16,entries[k].hash);
+    put64(p+24,entries[k].offset);
+    put64(p+32,entries[k].length);
+    p += ARCHIVE_ENTRY;
+  }
+  memcpy(p,info->params,info->paramslength);
+  p += info->paramslength;
+
+  put64(p,(unsigned long long)indexoffset);
+  put64(p+8,(unsigned long long)count);
+  put64(p+16,info->instances);
+  put64(p+24,info->masterseed);
+  put64(p+32,info->shard);
+  put64(p+40,info->shards);
+  put64(p+48,info->paramslength);
+  memcpy(p+56,INDEX_MAGIC,8);
+
+  result = write_all(fd,buf,size);
+  free(buf);
+  return result;
+}
+
+
+ARCHIVE *archive_open(const char *filename)
+{
+  ARCHIVE *a;
+  struct stat st;
+  const unsigned char *t;
+  unsigned long long count,paramslength,rest;
+  void *map;
+  int fd;
+
+  fd = open(filename,O_RDONLY);
+  if (fd<0) return NULL;
+  if ((fstat(fd,&st)!=0)||(st.st_size<ARCHIVE_HEADER+ARCHIVE_TRAILER)) {
+    close(fd);
+    return NULL;
+  }
+  map = mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if (map==MAP_FAILED) return NULL;
+
+  a = malloc(sizeof(ARCHIVE));
+  if (a==NULL) {
+    munmap(map,st.st_size);
+    return NULL;
+  }
+  a->map = map;
+  a->size = st.st_size;
+
+  // Check the magic numbers, then that the index, params and trailer
+  // exactly fill the end of the file
+  t = a->map + a->size - ARCHIVE_TRAILER;
+  if ((memcmp(a->map,MAGIC,8)!=0)||(memcmp(t+56,INDEX_MAGIC,8)!=0)) {
+    archive_close(a);
+    return NULL;
+  }
+  a->indexoffset = get64(t);
+  count = get64(t+8);
+  paramslength = get64(t+48);
+  rest = a->size - ARCHIVE_TRAILER;
+  if ((a->indexoffset<ARCHIVE_HEADER)||(a->indexoffset>rest)||
+      (count>(rest-a->indexoffset)/ARCHIVE_ENTRY)||
+      (paramslength!=rest-a->indexoffset-count*ARCHIVE_ENTRY)) {
+    archive_close(a);
+    return NULL;
+  }
+
+  a->count = (long long)count;
+  a->info.instances = get64(t+16);
+  a->info.masterseed = get64(t+24);
+  a->info.shard = get64(t+32);
+  a->info.shards = get64(t+40);
+  a->info.params = (const char *)a->map + a->indexoffset
+                   + count*ARCHIVE_ENTRY;
+  a->info.paramslength = paramslength;
+  return a;
+}
+
+
+long long archive_count(ARCHIVE *a)
+{
+  return a->count;
+}
+
+
+void archive_info(ARCHIVE *a, ARCHIVE_INFO *info)
+{
+  *info = a->info;
+}
+
+
+int archive_entry(ARCHIVE *a, long long k, ARCHIVE_ENTRY_INFO *entry)
+{
+  const unsigned char *p;
+
+  if ((k<0)||(k>=a->count)) return 1;
+  p = a->map + a->indexoffset + (unsigned long long)k*ARCHIVE_ENTRY;
+  entry->index = get64(p);
+  entry->seed = get64(p+8);
+  entry->hash = get64(p+16);
+  entry->offset = get64(p+24);
+  entry->length = get64(p+32);
+  if ((entry->offset<ARCHIVE_HEADER)||(entry->offset>a->indexoffset)||
+      (entry->length>a->indexoffset-entry->offset)) return 1;
+  return 0;
+}
+
+
+// The entries are in increasing order of index, and usually consecutive,
+// so the first guess is almost always right; otherwise bisect
+
+long long archive_find(ARCHIVE *a, unsigned long long index)
+{
+  ARCHIVE_ENTRY_INFO e;
+  long long lo,hi,mid;
+
+  if (a->count==0) return -1;
+  if (archive_entry(a,0,&e)!=0) return -1;
+  if ((index>=e.index)&&(index-e.index<(unsigned long long)a->count)) {
+    mid = (long long)(index-e.index);
+    if ((archive_entry(a,mid,&e)==0)&&(e.index==index)) return mid;
+  }
+
+  lo = 0;
+  hi = a->count - 1;
+  while (lo<=hi) {
+    mid = lo + (hi-lo)/2;
+    if (archive_entry(a,mid,&e)!=0) return -1;
+    if (e.index==index) return mid;
+    if (e.index<index) lo = mid + 1;
+    else hi = mid - 1;
+  }
+  return -1;
+}
+
+
+const char *archive_data(ARCHIVE *a, long long k, size_t *length)
+{
+  ARCHIVE_ENTRY_INFO e;
+
+  if (archive_entry(a,k,&e)!=0) return NULL;
+  *length = (size_t)e.length;
+  return (const char *)a->map + e.offset;
+}
+
+
+void archive_close(ARCHIVE *a)
+{
+  munmap((void *)a->map,a->size);
+  free(a);
+}
@@ -0,0 +1,42 @@
+// Header file for single-file archives of .cor instances
+
+#ifndef _ARCHIVE_H
+#define _ARCHIVE_H
+
+#include <stddef.h>
+
+#define ARCHIVE_HEADER  8          // Bytes before the first instance
+#define ARCHIVE_ENTRY   40         // Bytes per index entry
+#define ARCHIVE_TRAILER 64         // Bytes of the trailer at the end
+
+typedef struct {
+  unsigned long long index;        // Index of the instance in its batch
+  unsigned long long seed;
+  unsigned long long hash;         // FNV-1a 64-bit hash of the .cor file
+  unsigned long long offset;       // Position of the .cor file in the archive
+  unsigned long long length;       // Bytes of the .cor file
+} ARCHIVE_ENTRY_INFO;
+
+typedef struct {
+  unsigned long long instances;    // Instances in the whole batch
+  unsigned long long masterseed;
+  unsigned long long shard,shards;
+  const char *params;              // Not NUL-terminated
+  size_t paramslength;
+} ARCHIVE_INFO;
+
+typedef struct ARCHIVE ARCHIVE;
+
+int archive_begin(int fd);
+int archive_end(int fd, const ARCHIVE_INFO *info,
+                const ARCHIVE_ENTRY_INFO *entries, long long count);
+
+ARCHIVE *archive_open(const char *filename);
+long long archive_count(ARCHIVE *a);
+void archive_info(ARCHIVE *a, ARCHIVE_INFO *info);
+int archive_entry(ARCHIVE *a, long long k, ARCHIVE_ENTRY_INFO *entry);
+long long archive_find(ARCHIVE *a, unsigned long long index);
+const char *archive_data(ARCHIVE *a, long long k, size_t *length);
+void archive_close(ARCHIVE *a);
+
+#endif
@@ -21,7 +21,7 @@ CPAIOR-10: 7th International Conference on Integration of AI and OR Techniques i
 
 [2] Wildlife Corridors as a Connected Subgraph Problem 
 Jon Conrad, Carla P. Gomes, Willem-Jan van Hoeve, Ashish Sabharwal, Jordan F. Suter 
-JEEM: Journal of Environmental Economics and Management. Volume 63, Issue 1, pp 118, January 2012
+JEEM: Journal of Environmental Economics and Management. Volume 63, Issue 1, pp 1�18, January 2012
 
 [3] Connections in Networks: A Hybrid Approach 
 Carla P. Gomes, Willem-Jan van Hoeve, Ashish Sabharwal 
@@ -38,7 +38,7 @@ The generator allows for the specification of several parameters.
 It also allows for using an arbitrary network specified in the GML format, and generates the reserves, costs and utilities.
 http://www.fim.uni-passau.de/en/fim/faculty/chairs/theoretische-informatik/projects.html (GML project documentation)
 http://www-personal.umich.edu/~mejn/netdata/ (Datasets from Mark Newman)
-http://www-personal.umich.edu/~mejn/netdata/readgml.zip (We use C package for reading GML provided by Mark Newman)
+http://www-personal.umich.edu/~mejn/netdata/readgml.zip (GML files are read as Mark Newman's C package readgml reads them)
 
 The input is specified in the command line (see below); there are
 several options for the output (also specified in the command line),
@@ -93,8 +93,24 @@ Example of generating an instance:
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-#include "readgml.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "readgraph.h"
+#include "graphutil.h"
+#include "sampler.h"
+#include "writer.h"
+#include "archive.h"
+#include "raster.h"
+#include "graphcache.h"
+#include "adjpack.h"
+#include "server.h"
 #ifndef NT
 #include <sys/times.h>
 #include <sys/time.h>
@@ -109,6 +125,23 @@ Example of generating an instance:
 
 #define MAX_LINE_LENGTH 10000
 #define MAX_NAME_LENGTH 10000
+#define MAX_ARGS 64
+#define SAMPLE_BLOCK 4096 /* parcels per block of the xoshiro sampler */
+#define MAPPED_WRITE_MIN 65536 /* parcels from which a .cor file is written by several threads */
+
+#define MAX_FEATURES 64
+#define MAX_FEATURE_RESERVES 4096 /* more reserves: no pairwise distances */
+#define FEATURES_MAGIC "CORFEAT1"
+#define BIPARTITE_MAGIC "CORBIP01"
+
+/* formats of the MIP files written by gisp */
+#define MIP_LP 0
+#define MIP_MPS 1
+
+/* fields regenerated by resample */
+#define RESAMPLE_COSTS 1
+#define RESAMPLE_UTILS 2
+#define RESAMPLE_RESERVES 4
 
 char* version = "Oct10-2012";
 
@@ -127,41 +160,335 @@ int D = 0; 	/* global variable for utility interval [cj-d, cj+d] */
 int ReserveFree = 1; /* 1 - reserves are free */
 int R = 2; /*total  number of reserves inclduing fixed if applicable */
 int Corr =0; /* correlation - 0 uncorrelated ; 1 weak; */
-int *Cost;	/* cost[i] holds cost of parcel i */
-int *Util;	/* utility[i] holds utility of parcel i */
-int *Res;	/* res[i] binary variable whether  parcel is a reserve */
-int *NumNei;	/* NumNei[i] holds number of neighbors of parcel i */
+
+/* Node attributes are stored as narrow as their range allows: 1, 2 or 4
+   bytes per value, chosen by allocAttr() from the range of L and D. */
+typedef struct {
+	int width;	/* bytes per value: 1, 2 or 4 */
+	int isSigned;	/* 1 - values may be negative */
+	void *data;
+} ATTRARRAY;
+
+ATTRARRAY Cost;	/* getAttr(&Cost, i) is the cost of parcel i */
+ATTRARRAY Util;	/* getAttr(&Util, i) is the utility of parcel i */
+unsigned char *Res;	/* bit set: isReserve(i) whether parcel i is a reserve */
 int *Status;	/* Status[i] status of node in dfs */
-int *Id;	/* Id[i] holds id of parcel i */
-int **Neighbors;  /* neighbors[i][j] == neighbor j of parcel i; */
+ARC *AdjStart;	/* neighbors of parcel i are Adj[AdjStart[i]] ... Adj[AdjStart[i+1]-1]; */
+int *Adj;	/* its degree is AdjStart[i+1]-AdjStart[i] */
+ADJPACK *Packed;	/* with --adjacency packed, the neighbor lists instead of AdjStart and Adj */
+
+#define isReserve(i) ((Res[(i) >> 3] >> ((i) & 7)) & 1)
+#define setReserve(i) (Res[(i) >> 3] |= (unsigned char)(1 << ((i) & 7)))
+#define clearReserve(i) (Res[(i) >> 3] &= (unsigned char)~(1 << ((i) & 7)))
+#define degree(i) (Packed != NULL ? adjpack_degree(Packed, (i)) : (int)(AdjStart[(i)+1] - AdjStart[(i)]))
+
+/* Goes through the neighbors of parcel i in either form of the lists:
+	for (nbrBegin(i, &it); nbrNext(&it, &v); ) ...
+   nbrBegin() returns the degree of i */
+typedef struct {
+	int isPacked;	/* 1 - the lists are Packed */
+	ARC k, end;
+	ADJPACK_ITER packed;
+} NBRITER;
+
+static inline int nbrBegin(int i, NBRITER *it)
+{
+	it->isPacked = (Packed != NULL);
+	if (it->isPacked) {
+		it->k = it->end = 0;
+		return(adjpack_begin(Packed, i, &it->packed));
+	}
+	it->packed.p = NULL;
+	it->packed.left = it->packed.prev = 0;
+	it->k = AdjStart[i];
+	it->end = AdjStart[i+1];
+	return((int)(it->end - it->k));
+}
+
+static inline int nbrNext(NBRITER *it, int *v)
+{
+	if (it->isPacked)
+		return(adjpack_next(&it->packed, v));
+	if (it->k == it->end) return(0);
+	*v = Adj[it->k++];
+	return(1);
+}
+
+/* number of arcs (twice the edges) in either form of the lists */
+#define numArcs() (Packed != NULL ? (ARC)Packed->arcs : AdjStart[N])
+
+static inline int getAttr(ATTRARRAY *a, int i)
+{
+	switch (a->width) {
+	case 1: return a->isSigned ? ((signed char *)a->data)[i] : ((unsigned char *)a->data)[i];
+	case 2: return a->isSigned ? ((short *)a->data)[i] : ((unsigned short *)a->data)[i];
+	default: return ((int *)a->data)[i];
+	}
+}
+
+/* Stores values[0..n-1] as parcels first..first+n-1; one loop per width, so
+   that the compiler can vectorize it */
+static void setAttrBlock(ATTRARRAY *a, int first, const int *values, int n)
+{
+	int k;
+
+	if (a->width == 4) {
+		memcpy((int *)a->data + first, values, sizeof(int) * n);
+	}else if (a->width == 2 && a->isSigned) {
+		short *d = (short *)a->data + first;
+		for (k = 0; k < n; k++) d[k] = (short)values[k];
+	}else if (a->width == 2) {
+		unsigned short *d = (unsigned short *)a->data + first;
+		for (k = 0; k < n; k++) d[k] = (unsigned short)values[k];
+	}else if (a->isSigned) {
+		signed char *d = (signed char *)a->data + first;
+		for (k = 0; k < n; k++) d[k] = (signed char)values[k];
+	}else {
+		unsigned char *d = (unsigned char *)a->data + first;
+		for (k = 0; k < n; k++) d[k] = (unsigned char)values[k];
+	}
+}
+
+static inline void setAttr(ATTRARRAY *a, int i, int value)
+{
+	switch (a->width) {
+	case 1:
+		if (a->isSigned) ((signed char *)a->data)[i] = (signed char)value;
+		else ((unsigned char *)a->data)[i] = (unsigned char)value;
+		break;
+	case 2:
+		if (a->isSigned) ((short *)a->data)[i] = (short)value;
+		else ((unsigned short *)a->data)[i] = (unsigned short)value;
+		break;
+	default:
+		((int *)a->data)[i] = value;
+	}
+}
 unsigned long Seed;
 char     randomModel[MAX_NAME_LENGTH];
 char     correlation[MAX_NAME_LENGTH];
+int LatticeMode = 0; /* 1 - lattice instance, 0 - instance from a graph file */
+char Params[MAX_LINE_LENGTH]; /* generation parameters, as recorded in manifests */
+
+int Instances = 0; /* number of instances in a batch; 0 - single instance */
+int Shard = 0; /* index of this shard, 0 <= Shard < NumShards */
+int NumShards = 1; /* number of shards the batch is split into */
+int HaveMasterSeed = 0; /* 1 - MasterSeed was given with --master-seed */
+unsigned long MasterSeed = 0; /* seed from which all instance seeds of a batch are derived */
+int InstanceIndex = 0; /* index in the batch of the instance being generated */
+char StreamFrame[MAX_LINE_LENGTH] = ""; /* frame line of the instance written to a stream; "" - no frame */
+#define OUTPUT_FILES 0
+#define OUTPUT_ARCHIVE 1
+int Output = OUTPUT_FILES; /* a batch is written as: OUTPUT_FILES - .cor files and a manifest; OUTPUT_ARCHIVE - one archive */
+/* error message when a graph has more arcs than ARC (graphutil.h) holds */
+#define TOO_MANY_ARCS "too many edges for this build; rebuild with make INDEX64=1."
+
+int ArchiveFd = -1; /* descriptor of the archive being written, or -1 */
+int GraphFormat = -1; /* format of GRAPHFILE (GRAPH_* in readgraph.h); -1 - guess from the extension */
+int Threads = 0; /* number of threads; 0 - one per online processor */
+char GraphCache[MAX_NAME_LENGTH] = ""; /* directory of parsed graph files (--graph-cache); "" - no cache */
+int GraphMapped = 0; /* 1 - AdjStart and Adj are mapped from the cache, and are not freed */
+int PackAdjacency = 0; /* 1 - neighbor lists of graphs are packed (--adjacency packed), see packAdjacency() */
+int Reorder = ORDER_NONE; /* relabeling of graph parcels (ORDER_* in graphutil.h) */
+char reorderModel[MAX_NAME_LENGTH] = "none";
+int *Perm;	/* Perm[i] is the parcel of GRAPHFILE that became parcel i (--reorder) */
+int Rng = 0; /* costs and utilities from: 0 - random(); 1 - the xoshiro block sampler */
+#define SPACING_NONE 0
+#define SPACING_MIN 1
+#define SPACING_TARGET 2
+int SpacingModel = SPACING_NONE; /* placement of random reserves: SPACING_MIN - at least Spacing hops apart; SPACING_TARGET - also Spacing hops from the nearest one */
+int Spacing = 0; /* hop distance of --min-spacing or --target-spacing */
+char *SpacingNames[] = {"none", "min", "target"};
+
+/* Instance features written next to each instance with --features */
+#define FEATURES_NONE 0
+#define FEATURES_JSON 1
+#define FEATURES_BINARY 2
+typedef struct {
+	char *name;
+	int isInt;	/* 1 - the value is i, 0 - the value is d */
+	long long i;
+	double d;
+} FEATURE;
+
+int Features = FEATURES_NONE;
+FEATURE Feature[MAX_FEATURES];
+int NumFeatures = 0;
+long long *DegreeHist;	/* DegreeHist[k] is the number of parcels of degree k */
+long long FeatureHistLen = 0;
+int *ReserveDist;	/* hop distances between the reserves, pairs (0,1), (0,2) ... (1,2) ... */
+long long FeaturePairs = 0;
+
+/* With --bipartite FRAC, the variable-constraint graph of the MIP of
+   corMIPGen.py with budget_frac FRAC is written next to each instance */
+int Bipartite = 0;
+double BudgetFrac = 0;
+ARC *MIPArcStart;	/* flow arcs of the MIP, see buildMIPArcs() */
+int *MIPArc;
+ARC *MIPInStart;
+ARC *MIPInArc;
+
+/* With --solution FRACS, a feasible solution of the MIP of corMIPGen.py is
+   written to OUTFILE_FRAC.sol for each budget fraction FRAC */
+#define MAX_SOLUTIONS 16
+int NumSolutions = 0;
+double SolutionFrac[MAX_SOLUTIONS];
+
+/* With --coarsen LEVELS, coarser copies of each instance are written to
+   OUTFILE.c1.cor ... OUTFILE.cLEVELS.cor, see writeCoarsened() */
+#define MAX_COARSEN 16
+int Coarsen = 0;
+
+/* With --partition K, the parcels are split into K regions for
+   decomposition methods, written to OUTFILE.part, see writePartition() */
+int Parts = 0;
+
+/* Raster instances (raster): the costs and utilities of the parcels are
+   read from two rasters, see readRasters(), and only the reserves are drawn */
+int RasterMode = 0; /* 1 - costs and utilities come from rasters */
+int Downsample = 1; /* cells per side of the blocks of the rasters averaged into one parcel */
+int RasterRows = 0; /* blocks per column of the rasters */
+int RasterCols = 0; /* blocks per row of the rasters */
+int *RasterCost; /* RasterCost[i] and RasterUtil[i] are the cost and utility of parcel i */
+int *RasterUtil;
+int *RasterBlock; /* RasterBlock[i] is the block row*RasterCols+col of parcel i */
+
+/* Graph MIPs (gisp, mvc): edge e of the graph is {EdgeU[e],EdgeV[e]},
+   see numberEdges() */
+int MIPFormat = MIP_MPS; /* format of the MIP file: MIP_LP or MIP_MPS */
+char MIPBuffer[1 << 20]; /* stdio buffer of the MIP file */
+int NodeBase = 0;	/* number of the first node in variable names */
+ARC NumEdges = 0;
+int *EdgeU;
+int *EdgeV;
+ARC *EdgeLowerStart;	/* EdgeLower[EdgeLowerStart[j]...] are the edges {i,j}, i<j */
+ARC *EdgeLower;
+
+/* Generalized independent set instances (gisp) */
+double GispAlpha;	/* probability that an edge is removable */
+double NodeWeight = 100; /* benefit of a node in the independent set */
+double EdgeCost = 1;	/* cost of removing an edge */
+unsigned char *GispRemovable;	/* 1 if edge e is removable */
+
+/* Minimum weight vertex cover instances (mvc) */
+double *MVCWeight;	/* weight of each node, uniform in [0,1) */
+
+/* Generator server (serve): every worker keeps the graphs of the requests
+   it has served, see keepResident(), and runs each request in a child
+   process that finds them there */
+#define MAX_RESIDENT 16
+typedef struct {
+	char *name; /* GRAPHFILE, as given in the request */
+	int format;
+	long long size, mtime, mtimensec; /* of GRAPHFILE when it was read */
+	int n;
+	ARC *start;
+	int *adj;
+	int mapped; /* 1 - start and adj are mapped from the graph cache */
+	long long asymmetric; /* neighbors without a reverse arc */
+} RESIDENT;
+int Serving = 0; /* 1 - this process serves requests (serve) */
+int Workers = 0; /* worker processes of serve; 0 - one per online processor */
+RESIDENT Resident[MAX_RESIDENT];
+int NumResident = 0;
+int NextResident = 0; /* entry replaced when Resident is full */
 
 char* execname;
 /******************************************************************************/
 
 
 /* ADD FORWARD DECLARATIONS OF ALL FUNCTIONS HERE! */
+int allocAttr(ATTRARRAY *a, long long lo, long long hi);
 int allocCost(void);
 int allocStatus(void);
 int allocUtil(void);
 int allocRes(void);
-int allocNumNei();
-int allocId();
-int allocNeighbors(void);
-int checkNeighbors(int* NumNei, int ** Neighbors);
-int dfs(int curr, int* Id,  int* Status, int* NumNei, int** Neighbors);
-int dfsTop(int* Id, int* Status, int* NumNei, int** Neighbors);
+int checkNeighbors(void);
+int dfs(int curr, int* Status);
+int dfsTop(int* Status);
 int error(char*);
 unsigned long getSeed(void);
+unsigned long deriveSeed(unsigned long master, int index);
 int populateValues(char*);
+int drawReserves(char*);
+int drawValues(void);
+int sampleValues(void);
 int setRandomReserves(char*);
+int setSpacedReserves(char*);
+int readReserveFile(char *reservefile);
+
+int parseOptions(int argc, char *argv[], char *posv[]);
+void addParam(char *word);
+void setParams(int posc, char *posv[]);
+int generateInstances(char *outfile, int haveSeed, int argc, char *argv[]);
+int generateInstance(char *outfile, int argc, char *argv[], unsigned long long *hash, long long *bytes);
+int hashFile(char *filename, unsigned long long *hash, long long *bytes);
+int mergeManifests(char *outmanifest, int nmanifests, char *manifests[]);
+int listArchive(char *archivefile);
+int extractArchive(char *archivefile, char *indexstr, char *outfile);
 
 int readCorFile(char *infile);
-int writeCor(char *outfile,int argc, char *argv[]);
-void readGraph(FILE *graphfile);
-int writeCorFromGraph(char *outfile,int argc, char *argv[]);
+void corFileName(char *infile, char *corFile);
+void scanCorComment(char *p, char *eol);
+char *mapFile(char *filename, size_t *size);
+int scanInt(char **p, char *eol, int *value);
+int cmpInt(const void *a, const void *b);
+int isSymmetric(void);
+int labelComponents(void);
+int corStats(char *infile, int validate);
+int writeCor(char *outfile,int argc, char *argv[], unsigned long long *hash, long long *bytes);
+WRITER *openCor(char *outfile, unsigned long long *hash);
+int isStdout(char *outfile);
+void writeCommandLine(WRITER *w, int argc, char *argv[]);
+void readGraphFile(char *graphfile);
+int reorderGraph(char *outfile);
+int readRasters(char *costfile, char *utilfile);
+void rescaleRaster(double *mean, int n, int hi, int *value, int range[2], char *name);
+int writeRasterBlocks(char *outfile, char *costfile, char *utilfile);
+int numThreads(void);
+int packAdjacency(void);
+int writeCorFromGraph(char *outfile,int argc, char *argv[], unsigned long long *hash, long long *bytes);
+int writeCorMapped(char *outfile, char *header, size_t headerlen);
+int buildLatticeAdj(void);
+void addFeature(char *name, int isInt, long long i, double d);
+void addMoments(ATTRARRAY *a, char *names[5], double *mean);
+int computeFeatures(void);
+void putLE(FILE *fp, unsigned long long v, int n);
+int writeFeatures(char *outfile);
+int buildMIPArcs(void);
+long long writeMIPEntries(FILE *fp, int what, int root);
+void putMIPEntry(FILE *fp, int what, long long row, long long col, double coef);
+void putDouble(FILE *fp, double d);
+int writeBipartite(char *outfile);
+int writeSolutions(char *outfile);
+int writeCoarsened(char *outfile, int argc, char *argv[]);
+int writePartition(char *outfile);
+void bisectLattice(int r0, int r1, int c0, int c1, int k, int first, int *part);
+int writeCoarseCor(char *filename, int argc, char *argv[], int level, int n, int r,
+	ARC *start, int *adj, long long *util, long long *cost, unsigned char *res);
+int resampleCor(char *infile, char *fieldlist, char *outfile, int nseeds, char *seeds[]);
+int writeAttributes(char *attrfile, char *corFile, unsigned long long hash, int fields);
+double uniformDraw(void);
+int pairsToAdj(long long m, int *pair);
+int erdosRenyi(int n, double p);
+int barabasiAlbert(int n, int m);
+int powerlawCluster(int n, int m, double p);
+int wattsStrogatz(int n, int k, double p);
+int numberEdges(void);
+FILE *openMIPFile(char *outfile, char *mipfile);
+int partitionEdges(void);
+int writeGispLP(FILE *fp);
+int writeGispMPS(FILE *fp);
+int generateGisp(char *outfile, char *graph);
+int writeMVCLP(FILE *fp);
+int writeMVCMPS(FILE *fp);
+int generateMVC(char *outfile, char *graph);
+int runCommand(int argc, char *argv[]);
+int loadGraph(char *graphfile, int format, long long *asymmetric);
+int findResident(char *graphfile, int format, int current);
+void keepResident(int argc, char *argv[]);
+int serve(char *socketpath);
+int serveRequest(void *data, char *line, int body);
 
 
 void print_usage( char *execname){
@@ -181,61 +508,138 @@ void print_usage( char *execname){
 		printf("ORDER is the order of the lattice \n");
 		printf("L is the upper bound for the cost  interval per parcel,c_j, [1,L];\n");
 		printf("D is the amplitude for the  utility interval per parcel, [1,D] or  [c_j - D; c_j + D], depending on whether the correlation is uncorrelated or weak; \n");
-		printf("OUTFILE is the name of the output file (without extension);\n");
+		printf("OUTFILE is the name of the output file (without extension); - writes the instance to standard output;\n");
 		printf("ReserveFree is either 0 or 1; 1 meaning that reserve node cost is assigned to be 0; \n");
 		printf("[SEED] is an optional argument. if provided, the random number generator is initialized with SEED. \n\n");
 
 		printf("Usage2 : %s graph GRAPHFILE {file RESERVEFILE | random R}{uncorrelated | weak} L D OUTFILE ReserveFree [SEED]\n",execname);
-		printf("Where:\n GRAPHFILE - is a file describing a network in GML format\n ");
+		printf("Where:\n GRAPHFILE - is a file describing a network in GML, DIMACS (.clq, .col), edge list (.txt, .el, .edges) or METIS (.graph) format\n ");
 		printf("\n either a file listing the reserve nodes is specified by 'file RESERVEFILE' or R reserves are selected at random using 'random R' \n");
-		printf("\n R {uncorrelated|weak} L D OUTFILE ReserveFree [SEED] have same meaning as above  \n");
+		printf("\n R {uncorrelated|weak} L D OUTFILE ReserveFree [SEED] have same meaning as above  \n\n");
+
+		printf("Options (may be given anywhere on the command line of lattice, graph and raster):\n");
+		printf(" --instances M - generate a batch of M instances OUTFILE_0 ... OUTFILE_{M-1} and write a manifest; requires --master-seed\n");
+		printf(" --master-seed S - the seed of instance m of the batch is derived from S and m only\n");
+		printf(" --shard i/k - generate only the i-th of k contiguous slices of the batch (0 <= i < k); the manifest is OUTFILE.shard-i-of-k.manifest\n");
+		printf(" with OUTFILE -, the batch is written to standard output as a stream of framed instances instead of files and a manifest\n");
+		printf(" --output {files|archive} - write the batch as .cor files and a manifest (default), or as the single indexed archive OUTFILE.cora (see Usage8)\n");
+		printf(" --graph-format {gml|dimacs|edgelist|metis} - format of GRAPHFILE, if it cannot be told from the extension\n");
+		printf(" --threads T - number of threads used to read graph files (default: one per processor)\n");
+		printf(" --adjacency {arrays|packed} - keep the neighbor lists as arrays (default) or packed as varint coded differences, 2 to 3 times smaller for road and landscape graphs (not with --features, --bipartite, --solution, --coarsen or --partition)\n");
+		printf(" --graph-cache DIR - keep the parsed GRAPHFILE in the directory DIR, keyed by the hash and size of the file, so that later runs on it map the cached neighbor lists instead of parsing the file\n");
+		printf(" --rng {random|xoshiro} - draw costs and utilities with random() (default, as in earlier versions) or with the vectorized xoshiro128+ sampler (unbiased, much faster; different instances for the same SEED)\n");
+		printf(" --features {json|binary} - also write the features of each instance (degrees, reserve distances, cost and utility moments, budget bounds) to OUTFILE.features.json or OUTFILE.features\n");
+		printf(" --bipartite FRAC - also write the variable-constraint graph of the MIP that corMIPGen.py builds with --budget_frac FRAC to OUTFILE.bip\n");
+		printf(" --reorder {rcm|bfs|degree} - relabel the parcels of GRAPHFILE (reverse Cuthill-McKee, breadth first from a reserve, or by decreasing degree) and write the permutation to OUTFILE.perm\n");
+		printf(" --solution FRACS - also write a feasible solution (Steiner tree of the reserves, grown greedily by utility per cost) of the MIP that corMIPGen.py builds with --budget_frac FRAC to OUTFILE_FRAC.sol, for each FRAC of the comma separated list FRACS\n");
+		printf(" --coarsen LEVELS - also write LEVELS coarser copies of each instance to OUTFILE.c1.cor ... (2x2 blocks of the lattice per level, heavy edge matching of a graph), with the parcels of each level mapped to the next in OUTFILE.c1.map ...\n");
+		printf(" --partition K - also split the parcels into K regions of nearly equal size with few edges between them (recursive bisection of the lattice, multilevel label propagation on a graph) and write them with cut statistics to OUTFILE.part\n");
+		printf(" --min-spacing H - place the random reserves at least H hops apart from each other (and from the fixed ones of 2f+random)\n");
+		printf(" --target-spacing H - as --min-spacing, and place each new reserve exactly H hops from the nearest one whenever possible\n\n");
+
+		printf("Usage3 : %s merge OUTMANIFEST MANIFEST1 [MANIFEST2 ...]\n",execname);
+		printf("Where:\n the shard manifests MANIFEST1 ... are combined into OUTMANIFEST, ordered by instance index;\n");
+		printf(" duplicate or missing instances, and shards of batches with other params, are reported as errors\n\n");
+
+		printf("Usage4 : %s {stats | validate} CORFILE\n",execname);
+		printf("Where:\n stats prints statistics of the instance in CORFILE (with or without the .cor extension);\n");
+		printf(" validate also checks that ids, reserves and neighbor lists are consistent, and fails if not\n\n");
+
+		printf("Usage5 : %s resample CORFILE FIELDS OUTFILE SEED1 [SEED2 ...]\n",execname);
+		printf("Where:\n FIELDS is a comma separated list of costs, utilities and reserves, or all;\n");
+		printf(" for each seed (or range FIRST-LAST of seeds) these fields of CORFILE are drawn again, with the parameters recorded in its header,\n");
+		printf(" and written with the other fields to OUTFILE_seed.attr, which refers to CORFILE for the graph\n\n");
+
+		printf("Usage6 : %s gisp {graph GRAPHFILE | er NODES P} ALPHA OUTFILE [SEED]\n",execname);
+		printf("Where:\n a generalized independent set instance (as GISP/gisp.py builds it) is written to OUTFILE.mps or OUTFILE.lp\n");
+		printf(" (or to standard output for OUTFILE -);\n");
+		printf(" the graph is read from GRAPHFILE (any format of Usage2; nodes are numbered from 1) or drawn as an Erdos-Renyi graph\n");
+		printf(" with NODES nodes (numbered from 0) and edge probability P; every edge is removable with probability ALPHA\n");
+		printf("Options:\n");
+		printf(" --node-weight W - benefit of each node in the independent set (default 100)\n");
+		printf(" --edge-cost C - cost of removing an edge (default 1)\n");
+		printf(" --mip-format {mps|lp} - write OUTFILE.mps (default) or OUTFILE.lp in CPLEX LP format\n");
+		printf(" --graph-format and --threads as for Usage2\n\n");
+
+		printf("Usage7 : %s mvc {ba NODES M | er NODES P | powerlaw NODES M P | ws NODES K P | graph GRAPHFILE} OUTFILE [SEED]\n",execname);
+		printf("Where:\n a minimum weight vertex cover instance (as MVC/generator_MVC.py builds it) is written to OUTFILE.mps or OUTFILE.lp;\n");
+		printf(" the graph is a Barabasi-Albert graph (M edges per new node), an Erdos-Renyi graph (edge probability P),\n");
+		printf(" a Holme-Kim power law cluster graph (M edges per new node, triangle probability P), a Watts-Strogatz graph\n");
+		printf(" (K nearest neighbors, rewiring probability P), all on NODES nodes numbered from 0, or is read from GRAPHFILE\n");
+		printf(" (nodes numbered from 1); node weights are uniform in [0,1). --mip-format, --graph-format and --threads as above\n\n");
+
+		printf("Usage8 : %s list ARCHIVE\n",execname);
+		printf("        %s extract ARCHIVE INDEX OUTFILE\n",execname);
+		printf("Where:\n list prints the index of an archive written with --output archive;\n");
+		printf(" extract writes instance INDEX of ARCHIVE to OUTFILE.cor (or to standard output for OUTFILE -)\n\n");
+
+		printf("Usage9 : %s raster COSTRASTER UTILRASTER {file RESERVEFILE | random R | 2f+random R} L D OUTFILE ReserveFree [SEED]\n",execname);
+		printf("Where:\n the costs and utilities of the parcels are read from the rasters COSTRASTER and UTILRASTER (ESRI ASCII grids .asc,\n");
+		printf(" or binary rasters such as .flt with an ESRI .hdr header), one strip of rows at a time, and rescaled linearly to [1,L]\n");
+		printf(" and [1,D] (L or D of 0 rounds them as they are); NODATA cells are holes in the lattice, and only the reserves are drawn;\n");
+		printf(" OUTFILE.cells maps the parcels to the rasters. The options of Usage2 apply (except --reorder), and:\n");
+		printf(" --downsample F - each parcel is a block of FxF cells, with the mean cost and utility of its cells\n\n");
+
+		printf("Usage10 : %s serve SOCKET\n",execname);
+		printf("Where:\n requests are served on the Unix domain socket SOCKET until the server is stopped with SIGINT or SIGTERM;\n");
+		printf(" a request is one line with the arguments of any other usage, e.g. graph GRAPHFILE random 3 weak 100 100 - 1 7,\n");
+		printf(" and its reply is the line 'ok BYTES', or 'error STATUS BYTES', followed by the BYTES bytes the command writes to\n");
+		printf(" standard output (the instance, with OUTFILE -, or the error message); a connection can carry several requests.\n");
+		printf(" Each worker keeps the graph files of its requests in memory, and serves every request in a process of its own.\n");
+		printf(" Options given to serve (e.g. --graph-cache, --threads) apply to all requests, and:\n");
+		printf(" --workers W - number of worker processes, which serve requests concurrently (default: one per processor)\n");
 }
 
 int main(int argc, char *argv[])
 {
-	int      i;
-	char     command[MAX_NAME_LENGTH];
-	char     infile[MAX_NAME_LENGTH];
-	char     solfile[MAX_NAME_LENGTH];
-	char     selfile[MAX_NAME_LENGTH];
-	char     outfile[MAX_NAME_LENGTH];
-	char     GRAPHFILE[MAX_NAME_LENGTH];
-
-	FILE *fp;
-	
 	execname = argv[0];
 	if (argc <= 1 || (strcmp(argv[1], "-h") == 0)) {
 		print_usage(execname);
 		exit(-1);
 	}
+	return(runCommand(argc, argv));
+}
+
 
-	sscanf(argv[1], "%s", command);
+/* Runs the command of argv (any usage); requests of serve are run here too */
+int runCommand(int argc, char *argv[])
+{
+	int      posc;
+	int      haveSeed;
+	char    *posv[MAX_ARGS];
+	char     command[MAX_NAME_LENGTH];
+	char     outfile[MAX_NAME_LENGTH];
+	char     GRAPHFILE[MAX_NAME_LENGTH];
+	char     RESERVEFILE[MAX_NAME_LENGTH];
+
+	// options (--name value) may appear anywhere; the rest are positional
+	posc = parseOptions(argc, argv, posv);
+	if (posc <= 1) error("Bad arguments");
+
+	sscanf(posv[1], "%s", command);
 	if (strcmp(command, "graph") == 0) {
-		// Usage : corEncoder graph GRAPHFILE {file RESERVEFILE | random R}{uncorrelated | weak} ReserveFree NumParcels L D ANum ADen OUTFILE cor [SEED]
-		if (argc < 10) error("Bad arguments to graph");
-		char     RESERVEFILE[MAX_NAME_LENGTH];
+		// Usage : corEncoder graph GRAPHFILE {file RESERVEFILE | random R}{uncorrelated | weak} L D OUTFILE ReserveFree [SEED]
+		if (posc < 10) error("Bad arguments to graph");
 
-		sscanf(argv[2], "%s", GRAPHFILE); // graphfile
-		sscanf(argv[3], "%s", randomModel); // reserve or random
+		sscanf(posv[2], "%s", GRAPHFILE); // graphfile
+		sscanf(posv[3], "%s", randomModel); // reserve or random
 		if (strcmp(randomModel, "file")==0)
-			sscanf(argv[4], "%s", RESERVEFILE);
+			sscanf(posv[4], "%s", RESERVEFILE);
 		else if(strcmp(randomModel, "random")==0)
-			sscanf(argv[4], "%d", &R);
+			sscanf(posv[4], "%d", &R);
 		else
 		{
 			printf( "expected 'file' or 'random' but recieved: %s ", randomModel);
 			error("wrong model.");
 		}
-		sscanf(argv[5], "%s", correlation);
-		sscanf(argv[6], "%d", &L);
-		sscanf(argv[7], "%d", &D);
-		sscanf(argv[8], "%s", outfile);
-		sscanf(argv[9], "%d", &ReserveFree);
-		if (argc > 10)
-			sscanf(argv[10], "%lu", &Seed);
-		else
-			Seed = getSeed();
-		srandom(Seed);
+		sscanf(posv[5], "%s", correlation);
+		sscanf(posv[6], "%d", &L);
+		sscanf(posv[7], "%d", &D);
+		sscanf(posv[8], "%s", outfile);
+		sscanf(posv[9], "%d", &ReserveFree);
+		haveSeed = (posc > 10);
+		if (haveSeed)
+			sscanf(posv[10], "%lu", &Seed);
 
 		if ((strcmp(correlation, "uncorrelated")==0)){
 			Corr = 0;
@@ -254,59 +658,92 @@ int main(int argc, char *argv[])
 		fprintf(stderr,"read in args\n");
 		// read in parcel graph
 
-		fp = fopen(GRAPHFILE, "r");
-		if (fp == NULL) error((char*)"GRAPHFILE failed to open\n");
 		fprintf(stderr,"readGraph\n");
-		readGraph(fp); // sets N
+		readGraphFile(GRAPHFILE); // sets N
 
+		allocRes();
 		if (strcmp(randomModel, "file")==0){
-			// read in reserves
-			int nodeid;
-			R=0;
 			fprintf(stderr,"read Reserves\n");
-			fp = fopen(RESERVEFILE, "r");
-			if (fp == NULL) error((char*)"RESERVEFILE failed to open file\n");
-			while(fscanf(fp, "%d",&nodeid) != 1){
-				if(nodeid <0 || nodeid >= N){
-					printf("Reserve id %d. ", nodeid);
-					 error((char*)"Reserve id out of bounds[0,N)\n");
-				}
-				R++;
-			}
-			fclose(fp);
-			allocRes();
-			fp = fopen(RESERVEFILE, "r");
-			while(fscanf(fp, "%d", &nodeid) != 0){
-				Res[nodeid] = 1;
-			}
-			fclose(fp);
+			readReserveFile(RESERVEFILE); // sets R
 		}else if(strcmp(randomModel, "random")==0){
-			allocRes();
+			if (R > N || R < 0)
+				error("wrong value for R; Pick R such that 0 <= R <= N.");
 			fprintf(stderr,"alloc Reserves\n");
 		}
+		if (Reorder != ORDER_NONE)
+			reorderGraph(outfile);
+		packAdjacency();
 
 		allocCost();
 		allocUtil();
 
-		populateValues(randomModel);
+		setParams(posc, posv);
+		generateInstances(outfile, haveSeed, argc, argv);
+	}else if (strcmp(command, "raster") == 0) {
+		// Usage : corEncoder raster COSTRASTER UTILRASTER {file RESERVEFILE | random R | 2f+random R} L D OUTFILE ReserveFree [SEED]
+		char COSTRASTER[MAX_NAME_LENGTH];
+		char UTILRASTER[MAX_NAME_LENGTH];
+
+		if (posc < 10) error("Bad arguments to raster");
+		sscanf(posv[2], "%s", COSTRASTER);
+		sscanf(posv[3], "%s", UTILRASTER);
+		sscanf(posv[4], "%s", randomModel);
+		if (strcmp(randomModel, "file")==0)
+			sscanf(posv[5], "%s", RESERVEFILE);
+		else if ((strcmp(randomModel, "random")==0) ||
+			(strcmp(randomModel, "2f+random")==0))
+			sscanf(posv[5], "%d", &R);
+		else {
+			printf( "expected 'file', 'random' or '2f+random' but recieved: %s ", randomModel);
+			error("wrong model.");
+		}
+		sscanf(posv[6], "%d", &L);
+		sscanf(posv[7], "%d", &D);
+		sscanf(posv[8], "%s", outfile);
+		sscanf(posv[9], "%d", &ReserveFree);
+		haveSeed = (posc > 10);
+		if (haveSeed)
+			sscanf(posv[10], "%lu", &Seed);
+		if (L < 0 || D < 0)
+			error("wrong value for L or D; pick L, D >= 1, or 0 to keep the raster values.");
+		if (Reorder != ORDER_NONE)
+			error("--reorder cannot be used with raster.");
+
+		RasterMode = 1;
+		strcpy(correlation, "raster");
+		readRasters(COSTRASTER, UTILRASTER); // sets N
+		if (!isStdout(outfile))
+			writeRasterBlocks(outfile, COSTRASTER, UTILRASTER);
+		packAdjacency();
+
+		allocRes();
+		if (strcmp(randomModel, "file")==0) {
+			readReserveFile(RESERVEFILE); // sets R
+		}else if ((strcmp(randomModel, "2f+random")==0) && (R < 2 || R > N)) {
+			error("wrong value for R; Pick R such that 2 <= R <= N.");
+		}else if (R > N || R < 0) {
+			error("wrong value for R; Pick R such that 0 <= R <= N.");
+		}
 
-		writeCorFromGraph(outfile,argc,argv);
+		setParams(posc, posv);
+		generateInstances(outfile, haveSeed, argc, argv);
 	}else if (strcmp(command, "lattice") == 0) {
-		if (argc < 10) error("Bad arguments to lattice");
-		sscanf(argv[2], "%s", randomModel);
-		sscanf(argv[3], "%d", &R);
-		sscanf(argv[4], "%s", correlation);
-		sscanf(argv[5], "%d", &Order);
-		sscanf(argv[6], "%d", &L);
-		sscanf(argv[7], "%d", &D);
-		sscanf(argv[8], "%s", outfile);
-		sscanf(argv[9], "%d", &ReserveFree);
-		if (argc > 10)
-			sscanf(argv[10], "%lu", &Seed);
-		else
-			Seed = getSeed();
-		srandom(Seed);
-
+		if (posc < 10) error("Bad arguments to lattice");
+		sscanf(posv[2], "%s", randomModel);
+		sscanf(posv[3], "%d", &R);
+		sscanf(posv[4], "%s", correlation);
+		sscanf(posv[5], "%d", &Order);
+		sscanf(posv[6], "%d", &L);
+		sscanf(posv[7], "%d", &D);
+		sscanf(posv[8], "%s", outfile);
+		sscanf(posv[9], "%d", &ReserveFree);
+		haveSeed = (posc > 10);
+		if (haveSeed)
+			sscanf(posv[10], "%lu", &Seed);
+
+		LatticeMode = 1;
+		if ((long long)Order * Order > INT_MAX)
+			error("wrong value for ORDER; pick ORDER <= 46340 (at most 2^31-1 parcels, with or without INDEX64).");
 		N = Order *Order;
 
 		if ((strcmp(randomModel, "2f+random")==0) ||
@@ -340,73 +777,189 @@ int main(int argc, char *argv[])
 			error("wrong value for R; Pick R such that 0 <= R < Order*Order.");
 		}
 
-	Cost = (int *)malloc(sizeof(int) * N);
-	Util = (int *)malloc(sizeof(int) * N);
 		allocCost();
 		allocUtil();
 		allocRes();
 
-		populateValues(randomModel);
-		
-		writeCor(outfile,argc,argv);
-
-	}else error("Bad option");
-}
-
+		setParams(posc, posv);
+		generateInstances(outfile, haveSeed, argc, argv);
+
+	}else if (strcmp(command, "stats") == 0 || strcmp(command, "validate") == 0) {
+		// Usage : corEncoder {stats | validate} CORFILE
+		if (posc < 3) error("Bad arguments to stats");
+		corStats(posv[2], strcmp(command, "validate") == 0);
+	}else if (strcmp(command, "resample") == 0) {
+		// Usage : corEncoder resample CORFILE FIELDS OUTFILE SEED1 [SEED2 ...]
+		if (posc < 6) error("Bad arguments to resample");
+		resampleCor(posv[2], posv[3], posv[4], posc-5, posv+5);
+	}else if (strcmp(command, "gisp") == 0) {
+		// Usage : corEncoder gisp {graph GRAPHFILE | er NODES P} ALPHA OUTFILE [SEED]
+		int    a, nodes;
+		double p;
+		char   graph[MAX_NAME_LENGTH];
+
+		if (posc < 6) error("Bad arguments to gisp");
+		if (strcmp(posv[2], "graph") == 0) {
+			sscanf(posv[3], "%s", GRAPHFILE);
+			a = 4;
+		}else if (strcmp(posv[2], "er") == 0) {
+			if (posc < 7) error("Bad arguments to gisp");
+			if (sscanf(posv[3], "%d", &nodes) != 1 || nodes < 0)
+				error("wrong value for NODES; pick NODES >= 0.");
+			if (sscanf(posv[4], "%lf", &p) != 1 || p < 0 || p > 1)
+				error("wrong value for P; pick 0 <= P <= 1.");
+			a = 5;
+		}else {
+			printf("expected 'graph' or 'er' but recieved: %s ", posv[2]);
+			error("wrong graph.");
+		}
+		if (sscanf(posv[a], "%lf", &GispAlpha) != 1 || GispAlpha < 0 || GispAlpha > 1)
+			error("wrong value for ALPHA; pick 0 <= ALPHA <= 1.");
+		sscanf(posv[a+1], "%s", outfile);
+		if (posc > a+2)
+			sscanf(posv[a+2], "%lu", &Seed);
+		else
+			Seed = getSeed();
+		srandom(Seed);
 
+		if (a == 4) {
+			readGraphFile(GRAPHFILE);
+			NodeBase = 1;
+			snprintf(graph, sizeof(graph), "%s", GRAPHFILE);
+		}else {
+			erdosRenyi(nodes, p);
+			NodeBase = 0;
+			snprintf(graph, sizeof(graph), "er %d %.15g", nodes, p);
+		}
+		packAdjacency();
+		generateGisp(outfile, graph);
+	}else if (strcmp(command, "mvc") == 0) {
+		// Usage : corEncoder mvc {ba NODES M | er NODES P | powerlaw NODES M P | ws NODES K P | graph GRAPHFILE} OUTFILE [SEED]
+		int    a, nodes = 0, m = 0;
+		double p = 0;
+		char   graph[MAX_NAME_LENGTH];
+
+		if (posc < 5) error("Bad arguments to mvc");
+		if (strcmp(posv[2], "graph") == 0)
+			a = 4;
+		else if (strcmp(posv[2], "ba") == 0 || strcmp(posv[2], "er") == 0)
+			a = 5;
+		else if (strcmp(posv[2], "powerlaw") == 0 || strcmp(posv[2], "ws") == 0)
+			a = 6;
+		else {
+			printf("expected 'ba', 'er', 'powerlaw', 'ws' or 'graph' but recieved: %s ", posv[2]);
+			error("wrong graph.");
+		}
+		if (posc < a+1) error("Bad arguments to mvc");
+		if (a > 4 && (sscanf(posv[3], "%d", &nodes) != 1 || nodes < 0))
+			error("wrong value for NODES; pick NODES >= 0.");
+		if (strcmp(posv[2], "er") == 0) {
+			if (sscanf(posv[4], "%lf", &p) != 1 || p < 0 || p > 1)
+				error("wrong value for P; pick 0 <= P <= 1.");
+		}else if (a > 4) {
+			if (sscanf(posv[4], "%d", &m) != 1)
+				error("wrong value for M or K.");
+			if (a == 6 && sscanf(posv[5], "%lf", &p) != 1)
+				error("wrong value for P.");
+		}
+		sscanf(posv[a], "%s", outfile);
+		if (posc > a+1)
+			sscanf(posv[a+1], "%lu", &Seed);
+		else
+			Seed = getSeed();
+		srandom(Seed);
 
-int allocCost(void)
-{
-	Cost = (int *)malloc(sizeof(int) * N);
+		NodeBase = 0;
+		if (a == 4) {
+			sscanf(posv[3], "%s", GRAPHFILE);
+			readGraphFile(GRAPHFILE);
+			NodeBase = 1;
+			snprintf(graph, sizeof(graph), "%s", GRAPHFILE);
+		}else if (strcmp(posv[2], "ba") == 0) {
+			barabasiAlbert(nodes, m);
+			snprintf(graph, sizeof(graph), "ba %d %d", nodes, m);
+		}else if (strcmp(posv[2], "er") == 0) {
+			erdosRenyi(nodes, p);
+			snprintf(graph, sizeof(graph), "er %d %.15g", nodes, p);
+		}else if (strcmp(posv[2], "powerlaw") == 0) {
+			powerlawCluster(nodes, m, p);
+			snprintf(graph, sizeof(graph), "powerlaw %d %d %.15g", nodes, m, p);
+		}else {
+			wattsStrogatz(nodes, m, p);
+			snprintf(graph, sizeof(graph), "ws %d %d %.15g", nodes, m, p);
+		}
+		packAdjacency();
+		generateMVC(outfile, graph);
+	}else if (strcmp(command, "merge") == 0) {
+		// Usage : corEncoder merge OUTMANIFEST MANIFEST1 [MANIFEST2 ...]
+		if (posc < 4) error("Bad arguments to merge");
+		mergeManifests(posv[2], posc-3, posv+3);
+	}else if (strcmp(command, "list") == 0) {
+		// Usage : corEncoder list ARCHIVE
+		if (posc < 3) error("Bad arguments to list");
+		listArchive(posv[2]);
+	}else if (strcmp(command, "extract") == 0) {
+		// Usage : corEncoder extract ARCHIVE INDEX OUTFILE
+		if (posc < 5) error("Bad arguments to extract");
+		extractArchive(posv[2], posv[3], posv[4]);
+	}else if (strcmp(command, "serve") == 0) {
+		// Usage : corEncoder serve SOCKET
+		if (posc < 3) error("Bad arguments to serve");
+		if (Serving) error("serve cannot be requested from a server.");
+		serve(posv[2]);
+	}else error("Bad option");
 	return(0);
 }
 
 
 
-int allocStatus(void)
+/* Allocates N values in [lo,hi], in the narrowest width that holds them */
+int allocAttr(ATTRARRAY *a, long long lo, long long hi)
 {
-
-	Status = (int *)malloc(sizeof(int) * N);
+	a->isSigned = (lo < 0);
+	if (a->isSigned)
+		a->width = (lo >= -128 && hi <= 127) ? 1 : (lo >= -32768 && hi <= 32767) ? 2 : 4;
+	else
+		a->width = (hi <= 255) ? 1 : (hi <= 65535) ? 2 : 4;
+	if (lo < -2147483647LL - 1 || hi > 2147483647LL)
+		error("attribute range does not fit in an int.");
+	free(a->data);
+	a->data = malloc((size_t)a->width * (N > 0 ? N : 1));
+	if (a->data == NULL) error("out of memory.");
 	return(0);
 }
 
 
-int allocNumNei(void)
+/* costs are in [0,L] (0 for free reserves) */
+int allocCost(void)
 {
-
-	NumNei = (int *)malloc(sizeof(int) * N);
+	allocAttr(&Cost, 0, L);
 	return(0);
 }
 
 
-int allocNeighbors(void)
-{
-	int i;
-	Neighbors = (int **)malloc(sizeof(int *) * N);
-	for (i = 0; i < N; i++) {
-		Neighbors[i] = (int *)malloc(sizeof(int) * N);
-	}
-	return(0);
-}
 
-int allocId(void)
+int allocStatus(void)
 {
 
-	Id = (int *)malloc(sizeof(int) * N);
+	Status = (int *)malloc(sizeof(int) * N);
 	return(0);
 }
 
 
+/* utilities are in [1,D] (uncorrelated) or [c_j-D,c_j+D] (weak) */
 int allocUtil(void)
 {
-
-	Util = (int *)malloc(sizeof(int) * N);
+	if (Corr == 0)
+		allocAttr(&Util, 1, D);
+	else
+		allocAttr(&Util, -(long long)D, (long long)L + D);
 	return(0);
 }
+
 int allocRes(void)
 {
-
-	Res = (int *)malloc(sizeof(int) * N);
+	Res = (unsigned char *)calloc(N/8 + 1, 1);
 	return(0);
 }
 
@@ -427,104 +980,426 @@ unsigned long getSeed(void)
 	return (( tv.tv_sec & 0177 ) * 1000000) + tv.tv_usec;
 }
 
-int populateValues(char *randomModel){
+/* Seed of instance 'index' of a batch, so every instance has its own stream
+   no matter which shard makes it. The seeds are 32 bits, as srandom() takes,
+   so that passing one as SEED reproduces the instance: the index goes through
+   a 32-bit permutation keyed by splitmix64 of the master seed, and no two
+   instances of a batch get the same seed. */
+unsigned long deriveSeed(unsigned long master, int index)
+{
+	unsigned long long k;
+	uint32_t x;
+	int r;
+
+	k = (unsigned long long)master + 0x9E3779B97F4A7C15ULL;
+	k = (k ^ (k >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	k = (k ^ (k >> 27)) * 0x94D049BB133111EBULL;
+	k = k ^ (k >> 31);
+	x = (uint32_t)index;
+	for (r = 0; r < 2; r++) {
+		x ^= (uint32_t)(k >> (32*r));	/* each step is invertible */
+		x ^= x >> 16;
+		x *= 0x7FEB352DU;
+		x ^= x >> 15;
+		x *= 0x846CA68BU;
+		x ^= x >> 16;
+	}
+	return (unsigned long)x;
+}
 
+/* Moves options of the form "--name value" out of the way; the remaining
+   positional arguments (including argv[0]) are stored in posv. Returns their count. */
+int parseOptions(int argc, char *argv[], char *posv[])
+{
 	int i;
-	int sign;
-	// generate array of reserves, costs, and utilities
+	int posc = 0;
 
-	for (i = 0; i < N; i++) {
-		Res[i] = 0;
+	for (i = 0; i < argc; i++) {
+		if (strncmp(argv[i], "--", 2) != 0 || i == 0) {
+			if (posc >= MAX_ARGS) error("too many arguments.");
+			posv[posc++] = argv[i];
+			continue;
+		}
+		if (i+1 >= argc) {
+			printf("%s ", argv[i]);
+			error("option requires a value.");
+		}
+		if (strcmp(argv[i], "--instances")==0) {
+			if (sscanf(argv[i+1], "%d", &Instances) != 1 || Instances < 1)
+				error("wrong value for --instances; pick M >= 1.");
+		}else if (strcmp(argv[i], "--master-seed")==0) {
+			if (sscanf(argv[i+1], "%lu", &MasterSeed) != 1)
+				error("wrong value for --master-seed.");
+			HaveMasterSeed = 1;
+		}else if (strcmp(argv[i], "--graph-format")==0) {
+			GraphFormat = graph_format_from_name(argv[i+1]);
+			if (GraphFormat < 0)
+				error("wrong value for --graph-format; use gml, dimacs, edgelist or metis.");
+		}else if (strcmp(argv[i], "--graph-cache")==0) {
+			if (strlen(argv[i+1]) >= MAX_NAME_LENGTH) error("--graph-cache directory name too long.");
+			strcpy(GraphCache, argv[i+1]);
+		}else if (strcmp(argv[i], "--adjacency")==0) {
+			if (strcmp(argv[i+1], "arrays")==0)
+				PackAdjacency = 0;
+			else if (strcmp(argv[i+1], "packed")==0)
+				PackAdjacency = 1;
+			else
+				error("wrong value for --adjacency; use arrays or packed.");
+		}else if (strcmp(argv[i], "--threads")==0) {
+			if (sscanf(argv[i+1], "%d", &Threads) != 1 || Threads < 1)
+				error("wrong value for --threads; pick T >= 1.");
+		}else if (strcmp(argv[i], "--rng")==0) {
+			if (strcmp(argv[i+1], "random")==0)
+				Rng = 0;
+			else if (strcmp(argv[i+1], "xoshiro")==0)
+				Rng = 1;
+			else
+				error("wrong value for --rng; use random or xoshiro.");
+		}else if (strcmp(argv[i], "--bipartite")==0) {
+			if (sscanf(argv[i+1], "%lf", &BudgetFrac) != 1 || BudgetFrac < 0)
+				error("wrong value for --bipartite; pick a budget fraction >= 0.");
+			Bipartite = 1;
+		}else if (strcmp(argv[i], "--solution")==0) {
+			char *p = argv[i+1];
+			int n;
+
+			NumSolutions = 0;
+			while (NumSolutions < MAX_SOLUTIONS &&
+				sscanf(p, "%lf%n", &SolutionFrac[NumSolutions], &n) == 1 &&
+				SolutionFrac[NumSolutions] >= 0) {
+				NumSolutions++;
+				p += n;
+				if (*p != ',') break;
+				p++;
+			}
+			if (NumSolutions == 0 || *p != '\0')
+				error("wrong value for --solution; use budget fractions >= 0 separated by commas (at most 16).");
+		}else if (strcmp(argv[i], "--coarsen")==0) {
+			if (sscanf(argv[i+1], "%d", &Coarsen) != 1 || Coarsen < 1 || Coarsen > MAX_COARSEN)
+				error("wrong value for --coarsen; pick 1 <= LEVELS <= 16.");
+		}else if (strcmp(argv[i], "--partition")==0) {
+			if (sscanf(argv[i+1], "%d", &Parts) != 1 || Parts < 1)
+				error("wrong value for --partition; pick K >= 1.");
+		}else if (strcmp(argv[i], "--workers")==0) {
+			if (sscanf(argv[i+1], "%d", &Workers) != 1 || Workers < 1)
+				error("wrong value for --workers; pick W >= 1.");
+		}else if (strcmp(argv[i], "--downsample")==0) {
+			if (sscanf(argv[i+1], "%d", &Downsample) != 1 || Downsample < 1)
+				error("wrong value for --downsample; pick F >= 1.");
+		}else if (strcmp(argv[i], "--features")==0) {
+			if (strcmp(argv[i+1], "json")==0)
+				Features = FEATURES_JSON;
+			else if (strcmp(argv[i+1], "binary")==0)
+				Features = FEATURES_BINARY;
+			else
+				error("wrong value for --features; use json or binary.");
+		}else if (strcmp(argv[i], "--node-weight")==0) {
+			if (sscanf(argv[i+1], "%lf", &NodeWeight) != 1)
+				error("wrong value for --node-weight.");
+		}else if (strcmp(argv[i], "--edge-cost")==0) {
+			if (sscanf(argv[i+1], "%lf", &EdgeCost) != 1)
+				error("wrong value for --edge-cost.");
+		}else if (strcmp(argv[i], "--mip-format")==0) {
+			if (strcmp(argv[i+1], "lp")==0)
+				MIPFormat = MIP_LP;
+			else if (strcmp(argv[i+1], "mps")==0)
+				MIPFormat = MIP_MPS;
+			else
+				error("wrong value for --mip-format; use mps or lp.");
+		}else if (strcmp(argv[i], "--reorder")==0) {
+			Reorder = graph_order_from_name(argv[i+1]);
+			if (Reorder < 0)
+				error("wrong value for --reorder; use rcm, bfs or degree.");
+			strcpy(reorderModel, argv[i+1]);
+		}else if (strcmp(argv[i], "--min-spacing")==0 || strcmp(argv[i], "--target-spacing")==0) {
+			if (sscanf(argv[i+1], "%d", &Spacing) != 1 || Spacing < 1)
+				error("wrong value for the reserve spacing; pick H >= 1.");
+			SpacingModel = (strcmp(argv[i], "--min-spacing")==0) ? SPACING_MIN : SPACING_TARGET;
+		}else if (strcmp(argv[i], "--output")==0) {
+			if (strcmp(argv[i+1], "files")==0)
+				Output = OUTPUT_FILES;
+			else if (strcmp(argv[i+1], "archive")==0)
+				Output = OUTPUT_ARCHIVE;
+			else
+				error("wrong value for --output; use files or archive.");
+		}else if (strcmp(argv[i], "--shard")==0) {
+			if (sscanf(argv[i+1], "%d/%d", &Shard, &NumShards) != 2 ||
+				NumShards < 1 || Shard < 0 || Shard >= NumShards)
+				error("wrong value for --shard; use i/k with 0 <= i < k.");
+		}else {
+			printf("%s ", argv[i]);
+			error("unknown option.");
+		}
+		i++;
 	}
+	return(posc);
+}
+
+/* Appends one word to Params */
+void addParam(char *word)
+{
+	if (strlen(Params) + strlen(word) + 2 >= MAX_LINE_LENGTH)
+		error("parameters too long.");
+	if (Params[0] != '\0') strcat(Params, " ");
+	strcat(Params, word);
+}
+
+/* Params holds the generation parameters: the positional arguments without
+   OUTFILE and SEED, followed by the options that change the instance, so that
+   they and a seed reproduce it */
+void setParams(int posc, char *posv[])
+{
+	char *formats[] = {"gml", "dimacs", "edgelist", "metis"};
+	char number[32];
+	int i;
+
+	Params[0] = '\0';
+	for (i = 1; i < posc && i < 10; i++) {
+		if (i == 8) continue; // OUTFILE
+		addParam(posv[i]);
+	}
+	if (GraphFormat >= 0) {
+		addParam("--graph-format");
+		addParam(formats[GraphFormat]);
+	}
+	if (Rng == 1) {
+		addParam("--rng");
+		addParam("xoshiro");
+	}
+	if (Reorder != ORDER_NONE) {
+		addParam("--reorder");
+		addParam(reorderModel);
+	}
+	if (SpacingModel != SPACING_NONE) {
+		addParam((SpacingModel == SPACING_MIN) ? "--min-spacing" : "--target-spacing");
+		sprintf(number, "%d", Spacing);
+		addParam(number);
+	}
+}
+
+int populateValues(char *randomModel){
+
+	// generate array of reserves, costs, and utilities
+	drawReserves(randomModel);
+	fprintf(stderr,"past generate reserves\n");
+	drawValues();
+	fprintf(stderr,"past generate cost and utils\n");
+	return 0;
+}
+
+
+/* Picks the reserves of the model; reserves read from a file are kept as they are */
+int drawReserves(char *randomModel){
+
+	if (strcmp(randomModel, "file")!=0) {
+		memset(Res, 0, N/8 + 1);
+	}else if (SpacingModel != SPACING_NONE)
+		error("--min-spacing and --target-spacing apply to random reserves only.");
 	if (strcmp(randomModel, "2f+random")==0) {
-			Res[0] = 1;
-			Res[N-1] = 1;
+			setReserve(0);
+			setReserve(N-1);
 	}
 
+	if (SpacingModel != SPACING_NONE) {
+		setSpacedReserves(randomModel);
+		return 0;
+	}
 	if ((strcmp(randomModel, "random")==0) ||
 		(strcmp(randomModel, "2f+random")==0 && R > 2)) {
 			setRandomReserves(randomModel);
 	}
+	return 0;
+}
 
-	fprintf(stderr,"past generate reserves\n");
+
+/* Draws the costs and utilities of all parcels, given the reserves */
+int drawValues(void){
+
+	int i;
+	int sign;
+	int cost;
+
+	if (RasterMode) {
+		for (i = 0; i < N; i++) {
+			setAttr(&Cost, i, (ReserveFree==1 && isReserve(i)) ? 0 : RasterCost[i]);
+			setAttr(&Util, i, RasterUtil[i]);
+		}
+		return 0;
+	}
+	if (Rng == 1) {
+		sampleValues();
+		return 0;
+	}
 
 	///
 	for (i = 0; i < N; i++) {
-		if ( ReserveFree==1 && Res[i]==1) {
-			Cost[i] =0;
+		if ( ReserveFree==1 && isReserve(i)) {
+			cost =0;
 		}else {
-			Cost[i] = 1 + ( random() % L);
+			cost = 1 + ( random() % L);
 		}
+		setAttr(&Cost, i, cost);
 		if (Corr==0) {
-			Util[i] = 1 +  (random() % D);
+			setAttr(&Util, i, 1 +  (random() % D));
 		}else {
 			sign = random() % 2;
 			if (sign==1) // if random is 1 add
-			{Util[i] = Cost[i]  + ( random() % (D +1));}
+			{setAttr(&Util, i, cost  + ( random() % (D +1)));}
 			else
-			{Util[i] = Cost[i]  - ( random() % (D + 1));}
+			{setAttr(&Util, i, cost  - ( random() % (D + 1)));}
 		}
 	}
-
-	fprintf(stderr,"past generate cost and utils\n");
 	return 0;
 }
 
 
-int writeCor(char *outfile,int argc, char *argv[])
+/* Costs and utilities from the xoshiro128+ block sampler (--rng xoshiro),
+   seeded with Seed. Every parcel gets its draws, reserve or not, so the
+   values of a parcel do not depend on where the reserves are. */
+int sampleValues(void)
+{
+	SAMPLER g;
+	uint32_t cost[SAMPLE_BLOCK], util[SAMPLE_BLOCK], sign[SAMPLE_BLOCK];
+	int costs[SAMPLE_BLOCK], utils[SAMPLE_BLOCK];
+	int first, n, k;
+
+	sampler_seed(&g, Seed);
+	for (first = 0; first < N; first += n) {
+		n = (N - first < SAMPLE_BLOCK) ? N - first : SAMPLE_BLOCK;
+		sampler_uniform(&g, cost, n, L);
+		if (Corr == 0) {
+			sampler_uniform(&g, util, n, D);
+			for (k = 0; k < n; k++) {
+				costs[k] = 1 + (int)cost[k];
+				utils[k] = 1 + (int)util[k];
+			}
+		}else {
+			sampler_uniform(&g, sign, n, 2);
+			sampler_uniform(&g, util, n, D + 1);
+			for (k = 0; k < n; k++) {
+				costs[k] = 1 + (int)cost[k];
+			}
+		}
+		if (ReserveFree == 1) {
+			for (k = 0; k < n; k++) {
+				if (isReserve(first + k)) costs[k] = 0;
+			}
+		}
+		if (Corr == 1) {
+			for (k = 0; k < n; k++) {
+				utils[k] = sign[k] ? costs[k] + (int)util[k] : costs[k] - (int)util[k];
+			}
+		}
+		setAttrBlock(&Cost, first, costs, n);
+		setAttrBlock(&Util, first, utils, n);
+	}
+	return(0);
+}
+
+
+/* Writes the first line of a cor file: the command line, or for an instance
+   of a batch the generation parameters and its index, so that the instance
+   is the same however the batch is sharded and written */
+void writeCommandLine(WRITER *w, int argc, char *argv[])
+{
+	int i;
+
+	if (Instances > 0) {
+		writer_printf(w, "c params = %s\nc index = %d\n", Params, InstanceIndex);
+		return;
+	}
+	writer_printf(w, "c command line =");
+	for (i=0;i < argc;i++){
+		writer_printf(w, " %s", argv[i]);
+	}
+	writer_printf(w, "\n");
+}
+
+
+/* OUTFILE "-" stands for standard output */
+int isStdout(char *outfile)
 {
+	return(strcmp(outfile, "-") == 0);
+}
 
+
+/* Opens the writer of OUTFILE.cor, or of standard output for OUTFILE "-";
+   on standard output the instance is framed by StreamFrame, if set. While
+   an archive is written, the instance is appended to it instead */
+WRITER *openCor(char *outfile, unsigned long long *hash)
+{
 	char  corfilename[MAX_NAME_LENGTH];
-	FILE  *fp;
-	int   i, j;
-	int sign;
-	int resNum;
+	WRITER *w;
 
+	if (ArchiveFd >= 0) {
+		w = writer_fd(ArchiveFd, hash != NULL, NULL);
+		if (w == NULL) error((char*)"cannot write to the archive\n");
+		return(w);
+	}
+	if (isStdout(outfile)) {
+		w = writer_fd(1, hash != NULL, StreamFrame[0] != '\0' ? StreamFrame : NULL);
+		if (w == NULL) error((char*)"cannot write to standard output\n");
+		return(w);
+	}
 	strcpy(corfilename, outfile);
 	strcat(corfilename, ".cor");
 
-	fp = fopen(corfilename, "w");
+	w = writer_open(corfilename, hash != NULL);
+	if (w == NULL) error((char*)"cor file failed to open\n");
+	return(w);
+}
+
+
+int writeCor(char *outfile,int argc, char *argv[], unsigned long long *hash, long long *bytes)
+{
+
+	WRITER *w;
+	int   i, j;
+	int sign;
+	int resNum;
+
+	w = openCor(outfile, hash);
 
 
 	// Write to file
-	fprintf(fp, "c command line =");
-	for (i=0;i < argc;i++){
-		fprintf(fp, " %s", argv[i]);
-	}
-	fprintf(fp, "\n");
-	fprintf(fp, "c Seed = %lu\n",Seed);
-	fprintf(fp, "c \n");
-	fprintf(fp, "c Corridor instance\n");
-	fprintf(fp, "c Format:\n");
-	fprintf(fp, "c p n r\n");
-	fprintf(fp, "c   n is the number of parcels, n is  an integer;\n");
-	fprintf(fp, "c   r is the number of reserves, n is  an integer;\n");
-	fprintf(fp, "c n i b u c e i1 i2 ...  ie\n");
-	fprintf(fp, "c   i is the id number of the node, i is an integer; \n");
-	fprintf(fp, "c   b whether the node is a reserve; b is 0 or 1; \n");
-	fprintf(fp, "c   u is the utility of the node; u is an integer; \n");
-	fprintf(fp, "c   c is the cost of the node; c is an integer; \n");
-	fprintf(fp, "c   e is the number of neighboring nodes; e is an integer; \n");
-	fprintf(fp, "c   ij is the id of neighbor node j (j=1,2, ... ,e) \n");
-	fprintf(fp, "c  \n");
-	fprintf(fp, "c \n");
-	fprintf(fp, "c n = %d\n", Order*Order);
-	fprintf(fp, "c r = %d\n", R);
-	fprintf(fp, "c l = %d\n", L);
-	fprintf(fp, "c d = %d\n", D);
-	fprintf(fp, "c terminalmodel = %s\n", randomModel);
-	fprintf(fp, "c utilmodel = %s\n", correlation);
+	writeCommandLine(w, argc, argv);
+	writer_printf(w, "c Seed = %lu\n",Seed);
+	writer_printf(w, "c \n");
+	writer_printf(w, "c Corridor instance\n");
+	writer_printf(w, "c Format:\n");
+	writer_printf(w, "c p n r\n");
+	writer_printf(w, "c   n is the number of parcels, n is  an integer;\n");
+	writer_printf(w, "c   r is the number of reserves, n is  an integer;\n");
+	writer_printf(w, "c n i b u c e i1 i2 ...  ie\n");
+	writer_printf(w, "c   i is the id number of the node, i is an integer; \n");
+	writer_printf(w, "c   b whether the node is a reserve; b is 0 or 1; \n");
+	writer_printf(w, "c   u is the utility of the node; u is an integer; \n");
+	writer_printf(w, "c   c is the cost of the node; c is an integer; \n");
+	writer_printf(w, "c   e is the number of neighboring nodes; e is an integer; \n");
+	writer_printf(w, "c   ij is the id of neighbor node j (j=1,2, ... ,e) \n");
+	writer_printf(w, "c  \n");
+	writer_printf(w, "c \n");
+	writer_printf(w, "c n = %d\n", Order*Order);
+	writer_printf(w, "c r = %d\n", R);
+	writer_printf(w, "c l = %d\n", L);
+	writer_printf(w, "c d = %d\n", D);
+	writer_printf(w, "c terminalmodel = %s\n", randomModel);
+	writer_printf(w, "c utilmodel = %s\n", correlation);
+	if (Rng == 1)
+		writer_printf(w, "c rng = xoshiro\n");
+	if (SpacingModel != SPACING_NONE)
+		writer_printf(w, "c spacing = %s %d\n", SpacingNames[SpacingModel], Spacing);
 	///
 	for (i=0;i<Order*Order; i++){
-		if (Res[i]==1){
-			fprintf(fp, "c reserve %d\n", i);
+		if (isReserve(i)){
+			writer_printf(w, "c reserve %d\n", i);
 		}
 	}
 	///
-	fprintf(fp, "c \n");
-	fprintf(fp, "c \n");
+	writer_printf(w, "c \n");
+	writer_printf(w, "c \n");
 
-	fprintf(fp, "p %d %d\n", Order*Order, R);
+	writer_printf(w, "p %d %d\n", Order*Order, R);
 	for (i = 0; i < Order; i++) {
 		for (j = 0; j < Order; j++) {
 			if (i==0) {
@@ -532,269 +1407,3044 @@ int writeCor(char *outfile,int argc, char *argv[])
 				// top row
 				if (j==0) {
 					// upper left corner
-					fprintf(fp, "n %d %d %d %d %d %d %d\n",i*Order+j,
-						Res[i*Order+j], Util[i*Order+j],
-						Cost[i*Order+j], 2, 1, Order);
+					writer_printf(w, "n %d %d %d %d %d %d %d\n",i*Order+j,
+						isReserve(i*Order+j), getAttr(&Util, i*Order+j),
+						getAttr(&Cost, i*Order+j), 2, 1, Order);
 				}else if (j == (Order-1)) {
 					// upper right corner
-					fprintf(fp, "n %d %d %d %d %d %d %d\n",i*Order+j,
-						Res[i*Order+j], Util[i*Order+j],
-						Cost[i*Order+j], 2, Order-2, 2*Order-1);
+					writer_printf(w, "n %d %d %d %d %d %d %d\n",i*Order+j,
+						isReserve(i*Order+j), getAttr(&Util, i*Order+j),
+						getAttr(&Cost, i*Order+j), 2, Order-2, 2*Order-1);
 				}else
 					// a non-corner cell of top row
-					fprintf(fp, "n %d %d %d %d %d %d %d %d\n",i*Order+j,
-					Res[i*Order+j], Util[i*Order+j],
-					Cost[i*Order+j], 3, j-1, j+1, Order+j);
+					writer_printf(w, "n %d %d %d %d %d %d %d %d\n",i*Order+j,
+					isReserve(i*Order+j), getAttr(&Util, i*Order+j),
+					getAttr(&Cost, i*Order+j), 3, j-1, j+1, Order+j);
 			}else if (i==Order-1) {
 				// bottom row
 				if (j==0) {
 					// lower left corner
-					fprintf(fp, "n %d %d %d %d %d %d %d\n",i*Order+j,
-						Res[i*Order+j], Util[i*Order+j],
-						Cost[i*Order+j], 2, (i-1)*Order+j, i*Order+j+1);
+					writer_printf(w, "n %d %d %d %d %d %d %d\n",i*Order+j,
+						isReserve(i*Order+j), getAttr(&Util, i*Order+j),
+						getAttr(&Cost, i*Order+j), 2, (i-1)*Order+j, i*Order+j+1);
 				}
 
 				else if (j == (Order-1)) {
 					// upper right corner
-					fprintf(fp, "n %d %d %d %d %d %d %d\n",i*Order+j,
-						Res[i*Order+j], Util[i*Order+j],
-						Cost[i*Order+j], 2, (i-1)*Order+j, Order*Order-2);
+					writer_printf(w, "n %d %d %d %d %d %d %d\n",i*Order+j,
+						isReserve(i*Order+j), getAttr(&Util, i*Order+j),
+						getAttr(&Cost, i*Order+j), 2, (i-1)*Order+j, Order*Order-2);
 				}
 				else
 					// a non-corner cell of bottom row
-					fprintf(fp, "n %d %d %d %d %d %d %d %d\n",i*Order+j,
-					Res[i*Order+j], Util[i*Order+j],
-					Cost[i*Order+j], 3, (i-1)*Order+j, i*Order+j-1, i*Order+j+1);
+					writer_printf(w, "n %d %d %d %d %d %d %d %d\n",i*Order+j,
+					isReserve(i*Order+j), getAttr(&Util, i*Order+j),
+					getAttr(&Cost, i*Order+j), 3, (i-1)*Order+j, i*Order+j-1, i*Order+j+1);
 			}else
 				// a middle row
 				if (j==0) {
 					// left side
-					fprintf(fp, "n %d %d %d %d %d %d %d %d\n",i*Order+j,
-						Res[i*Order+j], Util[i*Order+j],
-						Cost[i*Order+j], 3, (i-1)*Order+j, i*Order+j+1,
+					writer_printf(w, "n %d %d %d %d %d %d %d %d\n",i*Order+j,
+						isReserve(i*Order+j), getAttr(&Util, i*Order+j),
+						getAttr(&Cost, i*Order+j), 3, (i-1)*Order+j, i*Order+j+1,
 						(i+1)*Order+j);
 				}
 				else if (j==Order-1){
 					//right side
-					fprintf(fp, "n %d %d %d %d %d %d %d %d\n",i*Order+j,
-						Res[i*Order+j], Util[i*Order+j],
-						Cost[i*Order+j], 3, (i-1)*Order+j, i*Order+j-1,
+					writer_printf(w, "n %d %d %d %d %d %d %d %d\n",i*Order+j,
+						isReserve(i*Order+j), getAttr(&Util, i*Order+j),
+						getAttr(&Cost, i*Order+j), 3, (i-1)*Order+j, i*Order+j-1,
 						(i+1)*Order+j);
 				}
 				else {
-					fprintf(fp, "n %d %d %d %d %d %d %d %d %d\n",i*Order+j,
-						Res[i*Order+j], Util[i*Order+j],
-						Cost[i*Order+j], 4, (i-1)*Order+j, i*Order+j-1,
+					writer_printf(w, "n %d %d %d %d %d %d %d %d %d\n",i*Order+j,
+						isReserve(i*Order+j), getAttr(&Util, i*Order+j),
+						getAttr(&Cost, i*Order+j), 4, (i-1)*Order+j, i*Order+j-1,
 						i*Order+j+1,(i+1)*Order+j);
 				}
 		}
 	}
-	fclose(fp);
+	writer_close(w, hash, bytes);
 	return(0);
 }
 
 
-int writeCorFromGraph(char *outfile,int argc, char *argv[])
+int writeCorFromGraph(char *outfile,int argc, char *argv[], unsigned long long *hash, long long *bytes)
 {
 
-	char  corfilename[MAX_NAME_LENGTH];
-	FILE  *fp;
-	int   i, j;
-	strcpy(corfilename, outfile);
-	strcat(corfilename, ".cor");
+	WRITER *w;
+	int   i, v;
+	NBRITER it;
+	int   mapped;
+	char  *header;
+	size_t headerlen;
 
-	fp = fopen(corfilename, "w");
+	/* A large single instance going to its own file is written by several
+	   threads (writeCorMapped); the header is formatted in memory first */
+	mapped = (hash == NULL && ArchiveFd < 0 && !isStdout(outfile) &&
+		N >= MAPPED_WRITE_MIN && numThreads() > 1);
+	if (mapped) {
+		w = writer_memory();
+		if (w == NULL) error("out of memory.");
+	}else
+		w = openCor(outfile, hash);
 
 
 	// Write to file
-	fprintf(fp, "c command line =");
-	for (i=0;i < argc;i++){
-		fprintf(fp, " %s", argv[i]);
-	}
-	fprintf(fp, "\n");
-	fprintf(fp, "c Seed = %lu\n",Seed);
-	fprintf(fp, "c \n");
-	fprintf(fp, "c Corridor instance\n");
-	fprintf(fp, "c Format:\n");
-	fprintf(fp, "c p n r\n");
-	fprintf(fp, "c   n is the number of parcels, n is  an integer;\n");
-	fprintf(fp, "c   r is the number of reserves, n is  an integer;\n");
-	fprintf(fp, "c n i b u c e i1 i2 ...  ie\n");
-	fprintf(fp, "c   i is the id number of the node, i is an integer; \n");
-	fprintf(fp, "c   b whether the node is a reserve; b is 0 or 1; \n");
-	fprintf(fp, "c   u is the utility of the node; u is an integer; \n");
-	fprintf(fp, "c   c is the cost of the node; c is an integer; \n");
-	fprintf(fp, "c   e is the number of neighboring nodes; e is an integer; \n");
-	fprintf(fp, "c   ij is the id of neighbor node j (j=1,2, ... ,e) \n");
-	fprintf(fp, "c  \n");
-	fprintf(fp, "c \n");
-	fprintf(fp, "c n = %d\n", N);
-	fprintf(fp, "c r = %d\n", R);
-	fprintf(fp, "c l = %d\n", L);
-	fprintf(fp, "c d = %d\n", D);
-	fprintf(fp, "c terminalmodel = %s\n", randomModel);
-	fprintf(fp, "c utilmodel = %s\n", correlation);
-	fflush(fp);
+	writeCommandLine(w, argc, argv);
+	writer_printf(w, "c Seed = %lu\n",Seed);
+	writer_printf(w, "c \n");
+	writer_printf(w, "c Corridor instance\n");
+	writer_printf(w, "c Format:\n");
+	writer_printf(w, "c p n r\n");
+	writer_printf(w, "c   n is the number of parcels, n is  an integer;\n");
+	writer_printf(w, "c   r is the number of reserves, n is  an integer;\n");
+	writer_printf(w, "c n i b u c e i1 i2 ...  ie\n");
+	writer_printf(w, "c   i is the id number of the node, i is an integer; \n");
+	writer_printf(w, "c   b whether the node is a reserve; b is 0 or 1; \n");
+	writer_printf(w, "c   u is the utility of the node; u is an integer; \n");
+	writer_printf(w, "c   c is the cost of the node; c is an integer; \n");
+	writer_printf(w, "c   e is the number of neighboring nodes; e is an integer; \n");
+	writer_printf(w, "c   ij is the id of neighbor node j (j=1,2, ... ,e) \n");
+	writer_printf(w, "c  \n");
+	writer_printf(w, "c \n");
+	writer_printf(w, "c n = %d\n", N);
+	writer_printf(w, "c r = %d\n", R);
+	writer_printf(w, "c l = %d\n", L);
+	writer_printf(w, "c d = %d\n", D);
+	writer_printf(w, "c terminalmodel = %s\n", randomModel);
+	writer_printf(w, "c utilmodel = %s\n", correlation);
+	if (Rng == 1)
+		writer_printf(w, "c rng = xoshiro\n");
+	if (SpacingModel != SPACING_NONE)
+		writer_printf(w, "c spacing = %s %d\n", SpacingNames[SpacingModel], Spacing);
+	if (Reorder != ORDER_NONE)
+		writer_printf(w, "c reorder = %s\n", reorderModel);
+	if (RasterMode)
+		writer_printf(w, "c raster = %d %d %d\n", RasterRows, RasterCols, Downsample);
 	///
 	for (i=0;i<N; i++){
-		if (Res[i]==1)
+		if (isReserve(i))
 		{
-			fprintf(fp, "c reserve %d\n", i);
+			writer_printf(w, "c reserve %d\n", i);
 		}
 	}
 	///
-	fprintf(fp, "c \n");
-	fprintf(fp, "c \n");
-
-	fprintf(fp, "p %d %d\n", N, R);
+	writer_printf(w, "c \n");
+	writer_printf(w, "c \n");
+
+	writer_printf(w, "p %d %d\n", N, R);
+	if (mapped) {
+		header = writer_detach(w, &headerlen);
+		writeCorMapped(outfile, header, headerlen);
+		free(header);
+		return(0);
+	}
 	for (i = 0; i < N; i++) {
-		fprintf(fp, "n %d %d %d %d %d ",i, Res[i], Util[i], Cost[i], NumNei[i]);
-		for(j = 0; j < NumNei[i]; j++)
-			fprintf(fp,"%d ", Neighbors[i][j]);
-		fprintf(fp, "\n");
+		writer_write(w, "n ", 2);
+		writer_int(w, i, ' ');
+		writer_int(w, isReserve(i), ' ');
+		writer_int(w, getAttr(&Util, i), ' ');
+		writer_int(w, getAttr(&Cost, i), ' ');
+		writer_int(w, nbrBegin(i, &it), ' ');
+		while (nbrNext(&it, &v))
+			writer_int(w, v, ' ');
+		writer_write(w, "\n", 1);
 	}
 
-	fclose(fp);
+	writer_close(w, hash, bytes);
 
 	return(0);
 }
 
 
-////////
+/* The node lines of a .cor file written by several threads: job k formats
+   the lines of parcels Lo ... Hi-1 into Map, line i starting at Offset[i] */
+typedef struct {
+	int   lo, hi;
+	long long *offset;
+	char  *map;
+} CORJOB;
 
-int setRandomReserves(char* randomModel){
 
-	int *array;
-	int i;
-	int resNum;
-	int slack=0;
-	int countOld=0;
+/* Number of characters of v in decimal */
+static inline int decimalLength(long long v)
+{
+	unsigned long long u;
+	int n = 1;
+
+	if (v < 0) {
+		n++;
+		u = 0ULL - (unsigned long long)v;
+	}else
+		u = (unsigned long long)v;
+	while (u >= 10) {
+		u /= 10;
+		n++;
+	}
+	return(n);
+}
 
-	if ((strcmp(randomModel, "random")==0)){
-		array = (int *)malloc(sizeof(int) * (N));
-		for (i=0; i<N; i++) {
-			array[i]= i;
-		}
-		for (i=0; i<R; i++) {
-			resNum = random() % (N-i);
-			Res[array[resNum]]=1;
-			array[resNum]=array[N-(i+1)];
-		}
-	}else if ((strcmp(randomModel, "2f+random")==0)){
-		array = (int *)malloc(sizeof(int) * (Order*Order-2));
-		for (i=0; i<Order*Order-2; i++) {
-			array[i]= i+1;
-		}
-		for (i=0; i<R-2; i++) {
 
-			resNum = random() % (Order*Order-2-i);
-			Res[array[resNum]]=1;
-			array[resNum]=array[Order*Order-2-(i+1)];
-		}
-	}else{
-		error("unknown random model.\n");
-	}
-	return(0);
+/* Writes v in decimal followed by sep at p; returns the end */
+static inline char *putDecimal(char *p, long long v, char sep)
+{
+	char  *q;
+	unsigned long long u;
+
+	if (v < 0) {
+		*p++ = '-';
+		u = 0ULL - (unsigned long long)v;
+	}else
+		u = (unsigned long long)v;
+	p += decimalLength((long long)u);
+	q = p;
+	do {
+		*--q = (char)('0' + u % 10);
+		u /= 10;
+	} while (u > 0);
+	*p++ = sep;
+	return(p);
 }
 
-int readCorFile(char *infile){
-	char  corFile[MAX_NAME_LENGTH];
+
+/* Sets Offset[i+1] to the length of the line of parcel i, as writeCorFromGraph writes it */
+static void *corLineLengths(void *arg)
+{
+	CORJOB *job = (CORJOB *)arg;
+	long long len;
+	int   i, v;
+	NBRITER it;
+
+	for (i = job->lo; i < job->hi; i++) {
+		len = 2 + decimalLength(i) + decimalLength(isReserve(i)) + decimalLength(getAttr(&Util, i))
+			+ decimalLength(getAttr(&Cost, i)) + decimalLength(nbrBegin(i, &it)) + 5 + 1;
+		while (nbrNext(&it, &v))
+			len += decimalLength(v) + 1;
+		job->offset[i+1] = len;
+	}
+	return(NULL);
+}
+
+
+static void *corLines(void *arg)
+{
+	CORJOB *job = (CORJOB *)arg;
+	char  *p;
+	int   i, v;
+	NBRITER it;
+
+	for (i = job->lo; i < job->hi; i++) {
+		p = job->map + job->offset[i];
+		*p++ = 'n';
+		*p++ = ' ';
+		p = putDecimal(p, i, ' ');
+		p = putDecimal(p, isReserve(i), ' ');
+		p = putDecimal(p, getAttr(&Util, i), ' ');
+		p = putDecimal(p, getAttr(&Cost, i), ' ');
+		p = putDecimal(p, nbrBegin(i, &it), ' ');
+		while (nbrNext(&it, &v))
+			p = putDecimal(p, v, ' ');
+		*p = '\n';
+	}
+	return(NULL);
+}
+
+
+/* Runs fn on the jobs, one thread each (in this thread if one cannot be started) */
+static void runCorJobs(void *(*fn)(void *), CORJOB *jobs, int njobs)
+{
+	pthread_t *threads;
+	int   *started;
+	int   k;
+
+	threads = (pthread_t *)malloc(sizeof(pthread_t) * njobs);
+	started = (int *)calloc(njobs, sizeof(int));
+	if (threads == NULL || started == NULL) error("out of memory.");
+	for (k = 1; k < njobs; k++)
+		started[k] = (pthread_create(&threads[k], NULL, fn, &jobs[k]) == 0);
+	fn(&jobs[0]);
+	for (k = 1; k < njobs; k++) {
+		if (started[k])
+			pthread_join(threads[k], NULL);
+		else
+			fn(&jobs[k]);
+	}
+	free(threads);
+	free(started);
+}
+
+
+/* Writes OUTFILE.cor as writeCorFromGraph does, with several threads: the
+   length of every node line is computed first, and their prefix sums give
+   each line its place in the file, which is sized with ftruncate and mapped
+   into memory; every thread then formats a range of lines (of about equal
+   size) straight into the mapping. The file is the same byte for byte. */
+int writeCorMapped(char *outfile, char *header, size_t headerlen)
+{
+	char  corfilename[MAX_NAME_LENGTH];
+	CORJOB *jobs;
+	long long *offset;
+	long long total, target;
+	char  *map;
+	int   fd, njobs, k, i, lo, hi, mid;
+
+	strcpy(corfilename, outfile);
+	strcat(corfilename, ".cor");
+
+	njobs = numThreads();
+	if (njobs > N) njobs = N > 0 ? N : 1;
+	jobs = (CORJOB *)malloc(sizeof(CORJOB) * njobs);
+	offset = (long long *)malloc(sizeof(long long) * ((size_t)N + 1));
+	if (jobs == NULL || offset == NULL) error("out of memory.");
+
+	for (k = 0; k < njobs; k++) {
+		jobs[k].lo = (int)(((long long)N * k) / njobs);
+		jobs[k].hi = (int)(((long long)N * (k+1)) / njobs);
+		jobs[k].offset = offset;
+	}
+	runCorJobs(corLineLengths, jobs, njobs);
+	offset[0] = (long long)headerlen;
+	for (i = 0; i < N; i++)
+		offset[i+1] += offset[i];
+	total = offset[N];
+
+	fd = open(corfilename, O_RDWR|O_CREAT|O_TRUNC, 0666);
+	if (fd < 0) error((char*)"cor file failed to open\n");
+	if (ftruncate(fd, (off_t)total) != 0)
+		error("cannot write the cor file.");
+	map = (char *)mmap(NULL, (size_t)total, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		error("cannot map the cor file.");
+	memcpy(map, header, headerlen);
+
+	// give every thread about the same number of bytes
+	for (k = 0; k < njobs; k++) {
+		target = (long long)headerlen + ((total - (long long)headerlen) / njobs) * k;
+		lo = 0;
+		hi = N;
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+			if (offset[mid] < target) lo = mid + 1;
+			else hi = mid;
+		}
+		jobs[k].lo = (k == 0) ? 0 : lo;
+		jobs[k].map = map;
+	}
+	for (k = 0; k < njobs; k++)
+		jobs[k].hi = (k + 1 < njobs) ? jobs[k+1].lo : N;
+	runCorJobs(corLines, jobs, njobs);
+
+	if (munmap(map, (size_t)total) != 0 || close(fd) != 0)
+		error("cannot write the cor file.");
+	free(jobs);
+	free(offset);
+	return(0);
+}
+
+
+////////
+
+/* Generates a single instance with the current Seed and queues it for
+   writing; *hash and *bytes are set once the writer thread has written it */
+int generateInstance(char *outfile, int argc, char *argv[], unsigned long long *hash, long long *bytes)
+{
+	srandom(Seed);
+	populateValues(randomModel);
+	if (LatticeMode)
+		writeCor(outfile,argc,argv,hash,bytes);
+	else
+		writeCorFromGraph(outfile,argc,argv,hash,bytes);
+	if (Features != FEATURES_NONE)
+		writeFeatures(outfile);
+	if (Bipartite)
+		writeBipartite(outfile);
+	if (NumSolutions > 0)
+		writeSolutions(outfile);
+	if (Coarsen > 0)
+		writeCoarsened(outfile, argc, argv);
+	if (Parts > 0)
+		writePartition(outfile);
+	return(0);
+}
+
+
+/* Generates either the single instance OUTFILE, or this shard's slice of a
+   batch of Instances instances. Instance m of a batch is written to OUTFILE_m
+   with seed deriveSeed(MasterSeed, m); a shard writes its own manifest,
+   so shards never need to know about each other. The .cor files are
+   written by the writer thread while the next instances are generated;
+   the manifest is written once they are all on disk.
+   For OUTFILE "-" a single instance is written to standard output as it is,
+   and a batch as a stream: the line "s instances masterseed shard shards
+   params", then for each instance the line "f index seed bytes" followed by
+   the bytes of its .cor file. No files or manifest are written.
+   With --output archive the batch goes to the single file OUTFILE.cora
+   (OUTFILE.shard-i-of-k.cora for a shard), indexed as in archive.c, instead
+   of .cor files and a manifest. */
+int generateInstances(char *outfile, int haveSeed, int argc, char *argv[])
+{
+	char  manifest[MAX_NAME_LENGTH];
+	char  archivefile[MAX_NAME_LENGTH];
+	char  instfile[MAX_NAME_LENGTH];
+	char  corfilename[MAX_NAME_LENGTH];
+	FILE  *fp;
+	WRITER *w;
+	int   m, lo, hi;
+	unsigned long long *hashes;
+	long long *sizes;
+	ARCHIVE_ENTRY_INFO *entries;
+	ARCHIVE_INFO info;
+	unsigned long long offset;
+
+	if (isStdout(outfile) && Features != FEATURES_NONE)
+		error("--features cannot be used with OUTFILE -.");
+	if (isStdout(outfile) && Bipartite)
+		error("--bipartite cannot be used with OUTFILE -.");
+	if (isStdout(outfile) && NumSolutions > 0)
+		error("--solution cannot be used with OUTFILE -.");
+	if (isStdout(outfile) && Coarsen > 0)
+		error("--coarsen cannot be used with OUTFILE -.");
+	if (isStdout(outfile) && Parts > 0)
+		error("--partition cannot be used with OUTFILE -.");
+
+	if (Instances == 0) {
+		if (NumShards > 1 || HaveMasterSeed)
+			error("--shard and --master-seed require --instances.");
+		if (Output == OUTPUT_ARCHIVE)
+			error("--output archive requires --instances.");
+		if (!haveSeed)
+			Seed = getSeed();
+		generateInstance(outfile, argc, argv, NULL, NULL);
+		if (writer_finish() != 0)
+			error("cannot write the cor file.");
+		return(0);
+	}
+	if (!HaveMasterSeed)
+		error("--instances requires --master-seed.");
+	if (strlen(outfile) + 64 >= MAX_NAME_LENGTH)
+		error("OUTFILE too long.");
+
+	lo = (int)(((long long)Instances * Shard) / NumShards);
+	hi = (int)(((long long)Instances * (Shard+1)) / NumShards);
+
+	if (isStdout(outfile)) {
+		w = writer_fd(1, 0, NULL);
+		if (w == NULL) error((char*)"cannot write to standard output\n");
+		writer_printf(w, "c corGenerator stream\n");
+		writer_printf(w, "c s instances masterseed shard shards params\n");
+		writer_printf(w, "c f index seed bytes, followed by the bytes of the cor file\n");
+		writer_printf(w, "s %d %lu %d %d %s\n", Instances, MasterSeed, Shard, NumShards, Params);
+		writer_close(w, NULL, NULL);
+		for (m = lo; m < hi; m++) {
+			InstanceIndex = m;
+			Seed = deriveSeed(MasterSeed, m);
+			sprintf(StreamFrame, "f %d %lu", m, Seed);
+			generateInstance(outfile, argc, argv, NULL, NULL);
+		}
+		StreamFrame[0] = '\0';
+		if (writer_finish() != 0)
+			error("cannot write the stream.");
+		fprintf(stderr, "shard %d/%d: wrote instances [%d,%d) to standard output\n", Shard, NumShards, lo, hi);
+		return(0);
+	}
+
+	if (Output == OUTPUT_ARCHIVE) {
+		if (NumShards > 1)
+			sprintf(archivefile, "%s.shard-%d-of-%d.cora", outfile, Shard, NumShards);
+		else
+			sprintf(archivefile, "%s.cora", outfile);
+		ArchiveFd = open(archivefile, O_WRONLY|O_CREAT|O_TRUNC, 0666);
+		if (ArchiveFd < 0 || archive_begin(ArchiveFd) != 0)
+			error((char*)"archive failed to open\n");
+		entries = (ARCHIVE_ENTRY_INFO *)malloc(sizeof(ARCHIVE_ENTRY_INFO) * (hi > lo ? hi - lo : 1));
+		if (entries == NULL) error("out of memory.");
+		// The writer thread appends the instances in the order they are closed
+		for (m = lo; m < hi; m++) {
+			InstanceIndex = m;
+			Seed = deriveSeed(MasterSeed, m);
+			sprintf(instfile, "%s_%d", outfile, m);
+			generateInstance(instfile, argc, argv, &entries[m-lo].hash, (long long *)&entries[m-lo].length);
+		}
+		if (writer_finish() != 0)
+			error("cannot write the archive.");
+		offset = ARCHIVE_HEADER;
+		for (m = lo; m < hi; m++) {
+			entries[m-lo].index = m;
+			entries[m-lo].seed = deriveSeed(MasterSeed, m);
+			entries[m-lo].offset = offset;
+			offset += entries[m-lo].length;
+		}
+		info.instances = Instances;
+		info.masterseed = MasterSeed;
+		info.shard = Shard;
+		info.shards = NumShards;
+		info.params = Params;
+		info.paramslength = strlen(Params);
+		if (archive_end(ArchiveFd, &info, entries, hi - lo) != 0 || close(ArchiveFd) != 0)
+			error("cannot write the archive.");
+		ArchiveFd = -1;
+		free(entries);
+		fprintf(stderr, "shard %d/%d: wrote instances [%d,%d) to %s\n", Shard, NumShards, lo, hi, archivefile);
+		return(0);
+	}
+
+	hashes = (unsigned long long *)malloc(sizeof(unsigned long long) * (hi > lo ? hi - lo : 1));
+	sizes = (long long *)malloc(sizeof(long long) * (hi > lo ? hi - lo : 1));
+	if (hashes == NULL || sizes == NULL) error("out of memory.");
+	for (m = lo; m < hi; m++) {
+		InstanceIndex = m;
+		Seed = deriveSeed(MasterSeed, m);
+		sprintf(instfile, "%s_%d", outfile, m);
+		generateInstance(instfile, argc, argv, &hashes[m-lo], &sizes[m-lo]);
+	}
+	if (writer_finish() != 0)
+		error("cannot write the cor files.");
+
+	if (NumShards > 1)
+		sprintf(manifest, "%s.shard-%d-of-%d.manifest", outfile, Shard, NumShards);
+	else
+		sprintf(manifest, "%s.manifest", outfile);
+	fp = fopen(manifest, "w");
+	if (fp == NULL) error((char*)"manifest failed to open\n");
+
+	fprintf(fp, "c corGenerator manifest\n");
+	fprintf(fp, "c m instances masterseed shard shards\n");
+	fprintf(fp, "c i index seed bytes fnv1a64 file params\n");
+	fprintf(fp, "m %d %lu %d %d\n", Instances, MasterSeed, Shard, NumShards);
+
+	for (m = lo; m < hi; m++) {
+		sprintf(corfilename, "%s_%d.cor", outfile, m);
+		fprintf(fp, "i %d %lu %lld %016llx %s %s\n", m, deriveSeed(MasterSeed, m),
+			sizes[m-lo], hashes[m-lo], corfilename, Params);
+	}
+	fclose(fp);
+	free(hashes);
+	free(sizes);
+	fprintf(stderr, "shard %d/%d: wrote instances [%d,%d) and %s\n", Shard, NumShards, lo, hi, manifest);
+	return(0);
+}
+
+
+/* Builds AdjStart/Adj for the lattice, with the neighbors that writeCor writes */
+int buildLatticeAdj(void)
+{
+	int i, j;
+	ARC k;
+
+	if (4LL * N > ARC_MAX) error(TOO_MANY_ARCS);
+	AdjStart = (ARC *)malloc(sizeof(ARC) * (N+1));
+	Adj = (int *)malloc(sizeof(int) * 4 * (size_t)(N > 0 ? N : 1));
+	if (AdjStart == NULL || Adj == NULL) error("out of memory.");
+	k = 0;
+	for (i = 0; i < Order; i++) {
+		for (j = 0; j < Order; j++) {
+			AdjStart[i*Order+j] = k;
+			if (i > 0) Adj[k++] = (i-1)*Order+j;
+			if (j > 0) Adj[k++] = i*Order+j-1;
+			if (j < Order-1) Adj[k++] = i*Order+j+1;
+			if (i < Order-1) Adj[k++] = (i+1)*Order+j;
+		}
+	}
+	AdjStart[N] = k;
+	return(0);
+}
+
+
+/* Appends a feature to Feature[] */
+void addFeature(char *name, int isInt, long long i, double d)
+{
+	if (NumFeatures >= MAX_FEATURES) error("too many features.");
+	Feature[NumFeatures].name = name;
+	Feature[NumFeatures].isInt = isInt;
+	Feature[NumFeatures].i = i;
+	Feature[NumFeatures].d = d;
+	NumFeatures++;
+}
+
+
+/* Adds the min, max, mean, standard deviation and skewness of the values
+   in a as the features names[0] ... names[4] */
+void addMoments(ATTRARRAY *a, char *names[5], double *mean)
+{
+	long long sum = 0;
+	int i, x, lo, hi;
+	double d, m2 = 0, m3 = 0, sd, skew = 0;
+
+	lo = hi = (N > 0) ? getAttr(a, 0) : 0;
+	for (i = 0; i < N; i++) {
+		x = getAttr(a, i);
+		sum += x;
+		if (x < lo) lo = x;
+		if (x > hi) hi = x;
+	}
+	*mean = (N > 0) ? (double)sum / N : 0;
+	for (i = 0; i < N; i++) {
+		d = getAttr(a, i) - *mean;
+		m2 += d * d;
+		m3 += d * d * d;
+	}
+	sd = (N > 0) ? sqrt(m2 / N) : 0;
+	if (sd > 0) skew = (m3 / N) / (sd * sd * sd);
+	addFeature(names[0], 1, lo, 0);
+	addFeature(names[1], 1, hi, 0);
+	addFeature(names[2], 0, 0, *mean);
+	addFeature(names[3], 0, 0, sd);
+	addFeature(names[4], 0, 0, skew);
+}
+
+
+/* Computes the features of the current instance: Feature[], and the arrays
+   DegreeHist (FeatureHistLen entries) and ReserveDist (FeaturePairs entries,
+   hop distances between the reserves, pairs in increasing order) */
+int computeFeatures(void)
+{
+	static char *costNames[5] = {"cost_min", "cost_max", "cost_mean", "cost_std", "cost_skew"};
+	static char *utilNames[5] = {"utility_min", "utility_max", "utility_mean", "utility_std", "utility_skew"};
+	int i, k, numRes, minDeg, maxDeg, unreachable, minDist, maxDist;
+	int *res, *weight;
+	long long totalCost = 0, totalUtil = 0, resCost = 0, bound;
+	long long *dist;
+	double costMean, utilMean, cov = 0, costVar = 0, utilVar = 0, corr = 0, distSum = 0;
+
+	if (LatticeMode && AdjStart == NULL)
+		buildLatticeAdj();
+	NumFeatures = 0;
+
+	// degrees
+	minDeg = maxDeg = (N > 0) ? degree(0) : 0;
+	for (i = 0; i < N; i++) {
+		if (degree(i) < minDeg) minDeg = degree(i);
+		if (degree(i) > maxDeg) maxDeg = degree(i);
+	}
+	free(DegreeHist);
+	FeatureHistLen = maxDeg + 1;
+	DegreeHist = (long long *)calloc(FeatureHistLen, sizeof(long long));
+	if (DegreeHist == NULL) error("out of memory.");
+	for (i = 0; i < N; i++) DegreeHist[degree(i)]++;
+
+	numRes = 0;
+	for (i = 0; i < N; i++) numRes += isReserve(i);
+	addFeature("n", 1, N, 0);
+	addFeature("r", 1, R, 0);
+	addFeature("reserves", 1, numRes, 0);
+	addFeature("edges", 1, AdjStart[N] / 2, 0);
+	addFeature("degree_min", 1, minDeg, 0);
+	addFeature("degree_max", 1, maxDeg, 0);
+	addFeature("degree_mean", 0, 0, (N > 0) ? (double)AdjStart[N] / N : 0);
+
+	// costs and utilities
+	addMoments(&Cost, costNames, &costMean);
+	addMoments(&Util, utilNames, &utilMean);
+	for (i = 0; i < N; i++) {
+		totalCost += getAttr(&Cost, i);
+		totalUtil += getAttr(&Util, i);
+		if (isReserve(i)) resCost += getAttr(&Cost, i);
+		cov += (getAttr(&Cost, i) - costMean) * (getAttr(&Util, i) - utilMean);
+		costVar += (getAttr(&Cost, i) - costMean) * (getAttr(&Cost, i) - costMean);
+		utilVar += (getAttr(&Util, i) - utilMean) * (getAttr(&Util, i) - utilMean);
+	}
+	if (costVar > 0 && utilVar > 0) corr = cov / sqrt(costVar * utilVar);
+	addFeature("cost_utility_corr", 0, 0, corr);
+	addFeature("total_cost", 1, totalCost, 0);
+	addFeature("total_utility", 1, totalUtil, 0);
+
+	// budget: corMIPGen.py uses budget_frac * total_cost; every solution
+	// holds a cheapest path from the first reserve to each other reserve
+	res = (int *)malloc(sizeof(int) * (numRes > 0 ? numRes : 1));
+	if (res == NULL) error("out of memory.");
+	k = 0;
+	for (i = 0; i < N; i++) {
+		if (isReserve(i)) res[k++] = i;
+	}
+	bound = 0;
+	if (numRes > 1) {
+		weight = (int *)malloc(sizeof(int) * N);
+		dist = (long long *)malloc(sizeof(long long) * N);
+		if (weight == NULL || dist == NULL) error("out of memory.");
+		for (i = 0; i < N; i++) weight[i] = getAttr(&Cost, i);
+		if (graph_weighted_distances(N, AdjStart, Adj, weight, res[0], dist))
+			error("out of memory.");
+		for (k = 1; k < numRes; k++) {
+			if (dist[res[k]] < 0) {
+				bound = -1;
+				break;
+			}
+			if (dist[res[k]] > bound) bound = dist[res[k]];
+		}
+		free(weight);
+		free(dist);
+	}
+	addFeature("reserve_cost", 1, resCost, 0);
+	addFeature("reserve_cost_ratio", 0, 0, totalCost > 0 ? (double)resCost / totalCost : 0);
+	addFeature("path_cost_bound", 1, bound, 0);
+	addFeature("path_cost_ratio", 0, 0, totalCost > 0 ? (double)bound / totalCost : 0);
+
+	// hop distances between reserves
+	free(ReserveDist);
+	ReserveDist = NULL;
+	FeaturePairs = 0;
+	if (numRes <= MAX_FEATURE_RESERVES)
+		FeaturePairs = (long long)numRes * (numRes - 1) / 2;
+	if (FeaturePairs > 0) {
+		ReserveDist = (int *)malloc(sizeof(int) * FeaturePairs);
+		if (ReserveDist == NULL) error("out of memory.");
+		if (graph_terminal_distances(N, AdjStart, Adj, numRes, res, ReserveDist))
+			error("out of memory.");
+	}
+	unreachable = 0;
+	minDist = maxDist = -1;
+	for (k = 0; k < FeaturePairs; k++) {
+		if (ReserveDist[k] < 0) {
+			unreachable++;
+			continue;
+		}
+		if (minDist < 0 || ReserveDist[k] < minDist) minDist = ReserveDist[k];
+		if (ReserveDist[k] > maxDist) maxDist = ReserveDist[k];
+		distSum += ReserveDist[k];
+	}
+	addFeature("reserve_pairs", 1, FeaturePairs, 0);
+	addFeature("unreachable_pairs", 1, unreachable, 0);
+	addFeature("distance_min", 1, minDist, 0);
+	addFeature("distance_max", 1, maxDist, 0);
+	addFeature("distance_mean", 0, 0, FeaturePairs > unreachable ? distSum / (FeaturePairs - unreachable) : -1);
+	addFeature("degree_histogram_length", 1, FeatureHistLen, 0);
+
+	free(res);
+	return(0);
+}
+
+
+/* Writes v to fp as n little-endian bytes */
+void putLE(FILE *fp, unsigned long long v, int n)
+{
+	unsigned char b[8];
+	int k;
+
+	for (k = 0; k < n; k++) {
+		b[k] = (unsigned char)(v & 0xff);
+		v >>= 8;
+	}
+	fwrite(b, 1, n, fp);
+}
+
+
+/* Writes the features of the current instance to OUTFILE.features.json or,
+   with --features binary, to OUTFILE.features (layout in the README) */
+int writeFeatures(char *outfile)
+{
+	char  featfile[MAX_NAME_LENGTH];
+	FILE  *fp;
+	unsigned long long bits;
+	long long k;
+	int   f;
+
+	computeFeatures();
+	if (strlen(outfile) + 16 >= MAX_NAME_LENGTH) error("OUTFILE too long.");
+	sprintf(featfile, "%s.features%s", outfile, Features == FEATURES_JSON ? ".json" : "");
+	fp = fopen(featfile, "w");
+	if (fp == NULL) error((char*)"features file failed to open\n");
+
+	if (Features == FEATURES_JSON) {
+		fprintf(fp, "{\n  \"seed\": %lu,\n", Seed);
+		for (f = 0; f < NumFeatures; f++) {
+			if (Feature[f].isInt)
+				fprintf(fp, "  \"%s\": %lld,\n", Feature[f].name, Feature[f].i);
+			else
+				fprintf(fp, "  \"%s\": %.17g,\n", Feature[f].name, Feature[f].d);
+		}
+		fprintf(fp, "  \"degree_histogram\": [");
+		for (k = 0; k < FeatureHistLen; k++)
+			fprintf(fp, k ? ", %lld" : "%lld", DegreeHist[k]);
+		fprintf(fp, "],\n  \"reserve_distances\": [");
+		for (k = 0; k < FeaturePairs; k++)
+			fprintf(fp, k ? ", %d" : "%d", ReserveDist[k]);
+		fprintf(fp, "]\n}\n");
+	}else {
+		fwrite(FEATURES_MAGIC, 1, 8, fp);
+		putLE(fp, (unsigned long long)Seed, 8);
+		for (f = 0; f < NumFeatures; f++) {
+			if (Feature[f].isInt) {
+				bits = (unsigned long long)Feature[f].i;
+			}else {
+				memcpy(&bits, &Feature[f].d, 8);
+			}
+			putLE(fp, bits, 8);
+		}
+		for (k = 0; k < FeatureHistLen; k++)
+			putLE(fp, (unsigned long long)DegreeHist[k], 8);
+		for (k = 0; k < FeaturePairs; k++)
+			putLE(fp, (unsigned long long)(unsigned int)ReserveDist[k], 4);
+	}
+	fclose(fp);
+	return(0);
+}
+
+
+/* Builds the flow arcs of the MIP of corMIPGen.py, in the order in which it
+   creates the flow variables. parseCor adds the arcs (i,j) and (j,i) for
+   every neighbor j on the line of node i, and networkx lists the arcs of a
+   node in the order they were first added: the arcs (i,j) with j < i that
+   come from earlier lines, then those of the line of i, then the others.
+   The arcs out of i are MIPArc[MIPArcStart[i]] ... ; MIPInArc[MIPInStart[j]] ...
+   are the positions of the arcs into j. */
+int buildMIPArcs(void)
+{
+	int i, j, pass;
+	ARC k;
+	long long count;
+	ARC *tstart, *fill;
+	int *tadj, *stamp;
+
+	if (LatticeMode && AdjStart == NULL)
+		buildLatticeAdj();
+
+	// transpose: the nodes whose lines list j, in increasing order
+	tstart = (ARC *)calloc(N+1, sizeof(ARC));
+	tadj = (int *)malloc(sizeof(int) * (AdjStart[N] > 0 ? AdjStart[N] : 1));
+	stamp = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	fill = (ARC *)malloc(sizeof(ARC) * (N > 0 ? N : 1));
+	if (tstart == NULL || tadj == NULL || stamp == NULL || fill == NULL) error("out of memory.");
+	for (k = 0; k < AdjStart[N]; k++) tstart[Adj[k]+1]++;
+	for (j = 0; j < N; j++) tstart[j+1] += tstart[j];
+	memcpy(fill, tstart, sizeof(ARC) * N);
+	for (i = 0; i < N; i++) {
+		for (k = AdjStart[i]; k < AdjStart[i+1]; k++) tadj[fill[Adj[k]]++] = i;
+	}
+
+	// arcs out of each node, without duplicates; counted, then stored
+	MIPArcStart = (ARC *)malloc(sizeof(ARC) * (N+1));
+	if (MIPArcStart == NULL) error("out of memory.");
+	MIPArc = NULL;
+	for (pass = 0; pass < 2; pass++) {
+		for (j = 0; j < N; j++) stamp[j] = -1;
+		count = 0;
+		for (i = 0; i < N; i++) {
+			/* a directed graph may have up to twice its arcs */
+			if (count > ARC_MAX - (AdjStart[i+1] - AdjStart[i]) - (tstart[i+1] - tstart[i]))
+				error(TOO_MANY_ARCS);
+			MIPArcStart[i] = (ARC)count;
+			for (k = tstart[i]; k < tstart[i+1] && tadj[k] < i; k++) {
+				if (stamp[tadj[k]] == i) continue;
+				stamp[tadj[k]] = i;
+				if (pass) MIPArc[count] = tadj[k];
+				count++;
+			}
+			for (k = AdjStart[i]; k < AdjStart[i+1]; k++) {
+				if (stamp[Adj[k]] == i) continue;
+				stamp[Adj[k]] = i;
+				if (pass) MIPArc[count] = Adj[k];
+				count++;
+			}
+			for (k = tstart[i]; k < tstart[i+1]; k++) {
+				if (tadj[k] < i || stamp[tadj[k]] == i) continue;
+				stamp[tadj[k]] = i;
+				if (pass) MIPArc[count] = tadj[k];
+				count++;
+			}
+		}
+		MIPArcStart[N] = (ARC)count;
+		if (!pass) {
+			MIPArc = (int *)malloc(sizeof(int) * (count > 0 ? count : 1));
+			if (MIPArc == NULL) error("out of memory.");
+		}
+	}
+
+	// arcs into each node, by increasing tail
+	MIPInStart = (ARC *)calloc(N+1, sizeof(ARC));
+	MIPInArc = (ARC *)malloc(sizeof(ARC) * (MIPArcStart[N] > 0 ? MIPArcStart[N] : 1));
+	if (MIPInStart == NULL || MIPInArc == NULL) error("out of memory.");
+	for (k = 0; k < MIPArcStart[N]; k++) MIPInStart[MIPArc[k]+1]++;
+	for (j = 0; j < N; j++) MIPInStart[j+1] += MIPInStart[j];
+	memcpy(fill, MIPInStart, sizeof(ARC) * N);
+	for (i = 0; i < N; i++) {
+		for (k = MIPArcStart[i]; k < MIPArcStart[i+1]; k++) MIPInArc[fill[MIPArc[k]]++] = k;
+	}
+
+	free(tstart);
+	free(tadj);
+	free(stamp);
+	free(fill);
+	return(0);
+}
+
+
+/* Goes through the nonzeros of the constraint matrix of corMIPGen.py, row
+   by row, and writes field "what" of each: 0 the constraint, 1 the
+   variable, 2 the coefficient; what < 0 only counts them. Variables are
+   purchase_i (i), flow_(i,j) (N + arc), x_0 and y_0t (N + arcs, + 1);
+   rows are (2), (3) for each reserve, (5), (6) for each arc, (7) for each
+   node and (8). Zero coefficients (free reserves in (2)) are left out. */
+long long writeMIPEntries(FILE *fp, int what, int root)
+{
+	long long nnz = 0, row = 0;
+	long long arcs = MIPArcStart[N];
+	long long x0 = N + arcs, y0t = N + arcs + 1;
+	int i, j;
+	ARC k;
+
+#define ENTRY(c, v) do { putMIPEntry(fp, what, row, (c), (v)); nnz++; } while (0)
+
+	// (2) budget
+	for (i = 0; i < N; i++) {
+		if (getAttr(&Cost, i) != 0) ENTRY(i, getAttr(&Cost, i));
+	}
+	row++;
+	// (3) reserves are purchased
+	for (i = 0; i < N; i++) {
+		if (isReserve(i)) {
+			ENTRY(i, 1.0);
+			row++;
+		}
+	}
+	// (5)
+	ENTRY(x0, 1.0);
+	ENTRY(y0t, 1.0);
+	row++;
+	// (6) flow only into purchased nodes
+	for (i = 0; i < N; i++) {
+		for (k = MIPArcStart[i]; k < MIPArcStart[i+1]; k++) {
+			ENTRY((long long)N + k, 1.0);
+			ENTRY(MIPArc[k], -(double)N);
+			row++;
+		}
+	}
+	// (7) flow conservation
+	for (j = 0; j < N; j++) {
+		for (k = MIPInStart[j]; k < MIPInStart[j+1]; k++) ENTRY((long long)N + MIPInArc[k], 1.0);
+		if (j == root) ENTRY(y0t, 1.0);
+		ENTRY(j, -1.0);
+		for (k = MIPArcStart[j]; k < MIPArcStart[j+1]; k++) ENTRY((long long)N + k, -1.0);
+		row++;
+	}
+	// (8)
+	for (i = 0; i < N; i++) ENTRY(i, 1.0);
+	ENTRY(y0t, -1.0);
+
+#undef ENTRY
+	return(nnz);
+}
+
+
+void putMIPEntry(FILE *fp, int what, long long row, long long col, double coef)
+{
+	unsigned long long bits;
+
+	if (what == 0) {
+		putLE(fp, (unsigned long long)row, 8);
+	}else if (what == 1) {
+		putLE(fp, (unsigned long long)col, 8);
+	}else if (what == 2) {
+		memcpy(&bits, &coef, 8);
+		putLE(fp, bits, 8);
+	}
+}
+
+
+void putDouble(FILE *fp, double d)
+{
+	unsigned long long bits;
+
+	memcpy(&bits, &d, 8);
+	putLE(fp, bits, 8);
+}
+
+
+/* Writes the variable-constraint bipartite graph of the MIP that
+   corMIPGen.py builds from the current instance with budget_frac
+   BudgetFrac to OUTFILE.bip (layout in the README) */
+int writeBipartite(char *outfile)
+{
+	char  bipfile[MAX_NAME_LENGTH];
+	FILE  *fp;
+	long long nvars, ncons, nnz, arcs, totalCost = 0;
+	int   i, what, root = -1, numRes = 0;
+
+	if (MIPArcStart == NULL)
+		buildMIPArcs();
+	for (i = 0; i < N; i++) {
+		if (isReserve(i)) {
+			if (root < 0) root = i;
+			numRes++;
+		}
+		totalCost += getAttr(&Cost, i);
+	}
+	if (root < 0) error("the MIP of corMIPGen.py needs at least one reserve.");
+
+	arcs = MIPArcStart[N];
+	nvars = N + arcs + 2;
+	ncons = 1 + numRes + 1 + arcs + N + 1;
+	nnz = writeMIPEntries(NULL, -1, root);
+
+	if (strlen(outfile) + 8 >= MAX_NAME_LENGTH) error("OUTFILE too long.");
+	sprintf(bipfile, "%s.bip", outfile);
+	fp = fopen(bipfile, "w");
+	if (fp == NULL) error((char*)"bipartite file failed to open\n");
+
+	fwrite(BIPARTITE_MAGIC, 1, 8, fp);
+	putLE(fp, (unsigned long long)nvars, 8);
+	putLE(fp, (unsigned long long)ncons, 8);
+	putLE(fp, (unsigned long long)nnz, 8);
+	putLE(fp, 4, 8);
+	putLE(fp, 2, 8);
+	putLE(fp, (unsigned long long)N, 8);
+	putLE(fp, (unsigned long long)arcs, 8);
+
+	for (what = 0; what < 3; what++)
+		writeMIPEntries(fp, what, root);
+
+	// variables: obj, type (1 binary, 0 continuous), lb, ub
+	for (i = 0; i < N; i++) {
+		putDouble(fp, -(double)getAttr(&Util, i));
+		putDouble(fp, 1.0);
+		putDouble(fp, 0.0);
+		putDouble(fp, 1.0);
+	}
+	for (i = 0; i < arcs + 2; i++) {
+		putDouble(fp, 0.0);
+		putDouble(fp, 0.0);
+		putDouble(fp, 0.0);
+		putDouble(fp, HUGE_VAL);
+	}
+
+	// constraints: rhs, sense (-1 <=, 0 =)
+	putDouble(fp, BudgetFrac * (double)totalCost);
+	putDouble(fp, -1.0);
+	for (i = 0; i < numRes; i++) {
+		putDouble(fp, 1.0);
+		putDouble(fp, 0.0);
+	}
+	putDouble(fp, (double)N);
+	putDouble(fp, 0.0);
+	for (i = 0; i < arcs; i++) {
+		putDouble(fp, 0.0);
+		putDouble(fp, -1.0);
+	}
+	for (i = 0; i < N + 1; i++) {
+		putDouble(fp, 0.0);
+		putDouble(fp, 0.0);
+	}
+	fclose(fp);
+	return(0);
+}
+
+
+/* Writes, for each budget fraction of --solution, a feasible solution of the
+   MIP that corMIPGen.py builds with that --budget_frac to OUTFILE_FRAC.sol, in
+   the format Gurobi reads as a MIP start, with its variable names
+   (purchase_i, flow_(i,j), x_0, y_0t). The reserves are joined by a
+   shortest-path Steiner tree on the parcel costs, rooted at the first
+   reserve as the MIP is, and the tree is then grown by the neighbors of
+   best utility per cost while the budget allows. The flow on a tree arc is
+   the size of the subtree it leads to. If even the tree exceeds a budget,
+   no file is written for it. */
+int writeSolutions(char *outfile)
+{
+	char  solfile[MAX_NAME_LENGTH];
+	FILE  *fp;
+	int   *cost, *util, *term, *treeParent, *treeOrder, *parent, *order, *size;
+	int   i, s, nterm, treeCount, count, status;
+	ARC   k;
+	long long totalCost, treeCost, spent, utility;
+	double budget;
+
+	if (MIPArcStart == NULL)
+		buildMIPArcs();
+	cost = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	util = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	term = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	treeParent = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	treeOrder = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	parent = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	order = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	size = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	if (cost == NULL || util == NULL || term == NULL || treeParent == NULL ||
+		treeOrder == NULL || parent == NULL || order == NULL || size == NULL)
+		error("out of memory.");
+
+	totalCost = 0;
+	nterm = 0;
+	for (i = 0; i < N; i++) {
+		cost[i] = getAttr(&Cost, i);
+		util[i] = getAttr(&Util, i);
+		totalCost += cost[i];
+		if (isReserve(i)) term[nterm++] = i;
+	}
+	if (nterm == 0) error("the MIP of corMIPGen.py needs at least one reserve.");
+
+	status = graph_steiner_tree(N, MIPArcStart, MIPArc, cost, nterm, term,
+		treeParent, treeOrder, &treeCount);
+	if (status == 1) error("out of memory.");
+	if (status == 2) {
+		fprintf(stderr, "solution: the reserves are not connected; no solution written\n");
+		return(1);
+	}
+	treeCost = 0;
+	for (k = 0; k < treeCount; k++) treeCost += cost[treeOrder[k]];
+
+	if (strlen(outfile) + 40 >= MAX_NAME_LENGTH) error("OUTFILE too long.");
+	for (s = 0; s < NumSolutions; s++) {
+		budget = SolutionFrac[s] * (double)totalCost;
+		if ((double)treeCost > budget) {
+			fprintf(stderr, "solution: the Steiner tree costs %lld, more than the budget %g of fraction %g; no solution written\n",
+				treeCost, budget, SolutionFrac[s]);
+			continue;
+		}
+		memcpy(parent, treeParent, sizeof(int) * N);
+		memcpy(order, treeOrder, sizeof(int) * treeCount);
+		count = treeCount;
+		spent = treeCost;
+		if (graph_greedy_grow(N, MIPArcStart, MIPArc, cost, util, budget, &spent,
+			parent, order, &count) != 0)
+			error("out of memory.");
+
+		/* subtree sizes, children before their parents */
+		utility = 0;
+		for (k = 0; k < count; k++) {
+			size[order[k]] = 1;
+			utility += util[order[k]];
+		}
+		for (k = count - 1; k > 0; k--) size[parent[order[k]]] += size[order[k]];
+
+		sprintf(solfile, "%s_%g.sol", outfile, SolutionFrac[s]);
+		fp = fopen(solfile, "w");
+		if (fp == NULL) error((char*)"solution file failed to open\n");
+		fprintf(fp, "# Solution of the MIP of corMIPGen.py with budget_frac %g, by corGenerator --solution\n", SolutionFrac[s]);
+		fprintf(fp, "# parcels %d cost %lld budget %.17g\n", count, spent, budget);
+		fprintf(fp, "# Objective value = %lld\n", -utility);
+		for (i = 0; i < N; i++)
+			fprintf(fp, "purchase_%d %d\n", i, parent[i] != -2);
+		for (i = 0; i < N; i++) {
+			for (k = MIPArcStart[i]; k < MIPArcStart[i+1]; k++)
+				fprintf(fp, "flow_(%d,%d) %d\n", i, MIPArc[k],
+					parent[MIPArc[k]] == i ? size[MIPArc[k]] : 0);
+		}
+		fprintf(fp, "x_0 %d\n", N - count);
+		fprintf(fp, "y_0t %d\n", count);
+		fclose(fp);
+	}
+
+	free(cost);
+	free(util);
+	free(term);
+	free(treeParent);
+	free(treeOrder);
+	free(parent);
+	free(order);
+	free(size);
+	return(0);
+}
+
+
+/* Writes Coarsen levels of coarser copies of the instance, for multilevel
+   methods. Level l merges the parcels of level l-1 (the instance itself for
+   l = 1): a lattice into 2x2 blocks, so that level l is a lattice of
+   2^l x 2^l blocks, and a graph by heavy edge matching, the weight of an
+   edge being the number of edges of the instance it stands for. A merged
+   parcel costs the sum of the costs of its parcels, has the sum of their
+   utilities, and is a reserve if any of them is. Level l goes to
+   OUTFILE.cl.cor, and OUTFILE.cl.map gives for each parcel of level l-1 its
+   parcel of level l. A graph stops early once no two parcels can be merged. */
+int writeCoarsened(char *outfile, int argc, char *argv[])
+{
+	char  filename[MAX_NAME_LENGTH];
+	FILE  *fp;
+	ARC   *start, *cstart;
+	int   *adj, *weight, *map, *cadj, *cweight;
+	long long *cost, *util, *ccost, *cutil;
+	unsigned char *res, *cres;
+	int   n, nc, order, corder, level, i, j, r;
+
+	if (strlen(outfile) + 16 >= MAX_NAME_LENGTH) error("OUTFILE too long.");
+	if (AdjStart == NULL)
+		buildLatticeAdj();
+	n = N;
+	order = Order;
+	start = AdjStart;
+	adj = Adj;
+	weight = NULL;
+	cost = (long long *)malloc(sizeof(long long) * (N > 0 ? N : 1));
+	util = (long long *)malloc(sizeof(long long) * (N > 0 ? N : 1));
+	res = (unsigned char *)malloc(N > 0 ? N : 1);
+	if (cost == NULL || util == NULL || res == NULL) error("out of memory.");
+	for (i = 0; i < N; i++) {
+		cost[i] = getAttr(&Cost, i);
+		util[i] = getAttr(&Util, i);
+		res[i] = isReserve(i);
+	}
+
+	for (level = 1; level <= Coarsen; level++) {
+		map = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+		if (map == NULL) error("out of memory.");
+		corder = 0;
+		if (LatticeMode) {
+			corder = (order + 1) / 2;
+			for (i = 0; i < order; i++) {
+				for (j = 0; j < order; j++)
+					map[i*order+j] = (i/2)*corder + j/2;
+			}
+			nc = corder * corder;
+		}else {
+			nc = graph_heavy_matching(n, start, adj, weight, map);
+			if (nc < 0) error("out of memory.");
+		}
+		if (nc == n) {
+			fprintf(stderr, "coarsen: no parcels of level %d can be merged; stopping\n", level-1);
+			free(map);
+			break;
+		}
+
+		cstart = (ARC *)malloc(sizeof(ARC) * (nc+1));
+		cadj = (int *)malloc(sizeof(int) * (start[n] > 0 ? start[n] : 1));
+		cweight = (int *)malloc(sizeof(int) * (start[n] > 0 ? start[n] : 1));
+		ccost = (long long *)calloc(nc, sizeof(long long));
+		cutil = (long long *)calloc(nc, sizeof(long long));
+		cres = (unsigned char *)calloc(nc, 1);
+		if (cstart == NULL || cadj == NULL || cweight == NULL || ccost == NULL ||
+			cutil == NULL || cres == NULL)
+			error("out of memory.");
+		if (graph_contract(n, start, adj, weight, map, nc, cstart, cadj, cweight) != 0)
+			error("out of memory.");
+		for (i = 0; i < n; i++) {
+			ccost[map[i]] += cost[i];
+			cutil[map[i]] += util[i];
+			cres[map[i]] |= res[i];
+		}
+		r = 0;
+		for (i = 0; i < nc; i++) {
+			/* readCorFile and corMIPGen.py read them as ints */
+			if (ccost[i] > 2147483647LL || cutil[i] > 2147483647LL ||
+				ccost[i] < -2147483647LL || cutil[i] < -2147483647LL)
+				error("the costs or utilities of a coarse parcel do not fit in an int.");
+			r += cres[i];
+		}
+
+		sprintf(filename, "%s.c%d.cor", outfile, level);
+		writeCoarseCor(filename, argc, argv, level, nc, r, cstart, cadj, cutil, ccost, cres);
+
+		sprintf(filename, "%s.c%d.map", outfile, level);
+		fp = fopen(filename, "w");
+		if (fp == NULL) error((char*)"map file failed to open\n");
+		if (level == 1)
+			fprintf(fp, "c parcels of %s.cor merged into those of %s.c1.cor by --coarsen\n", outfile, outfile);
+		else
+			fprintf(fp, "c parcels of %s.c%d.cor merged into those of %s.c%d.cor by --coarsen\n",
+				outfile, level-1, outfile, level);
+		fprintf(fp, "c m i j - parcel i of level %d is in parcel j of level %d\n", level-1, level);
+		for (i = 0; i < n; i++) {
+			fprintf(fp, "m %d %d\n", i, map[i]);
+		}
+		fclose(fp);
+
+		if (start != AdjStart) {
+			free(start);
+			free(adj);
+		}
+		free(weight);
+		free(cost);
+		free(util);
+		free(res);
+		free(map);
+		n = nc;
+		order = corder;
+		start = cstart;
+		adj = cadj;
+		weight = cweight;
+		cost = ccost;
+		util = cutil;
+		res = cres;
+		if (n == 1) {
+			if (level < Coarsen)
+				fprintf(stderr, "coarsen: level %d has a single parcel; stopping\n", level);
+			break;
+		}
+	}
+
+	if (start != AdjStart) {
+		free(start);
+		free(adj);
+	}
+	free(weight);
+	free(cost);
+	free(util);
+	free(res);
+	return(0);
+}
+
+
+/* Writes level "level" of writeCoarsened() to "filename", in the format
+   of writeCorFromGraph */
+int writeCoarseCor(char *filename, int argc, char *argv[], int level, int n, int r,
+	ARC *start, int *adj, long long *util, long long *cost, unsigned char *res)
+{
+	WRITER *w;
+	int   i;
+	ARC   j;
+
+	w = writer_open(filename, 0);
+	if (w == NULL) error((char*)"cor file failed to open\n");
+
+	writeCommandLine(w, argc, argv);
+	writer_printf(w, "c Seed = %lu\n",Seed);
+	writer_printf(w, "c \n");
+	writer_printf(w, "c Corridor instance, level %d of --coarsen (see the .map files)\n", level);
+	writer_printf(w, "c \n");
+	writer_printf(w, "c n = %d\n", n);
+	writer_printf(w, "c r = %d\n", r);
+	writer_printf(w, "c l = %d\n", L);
+	writer_printf(w, "c d = %d\n", D);
+	writer_printf(w, "c terminalmodel = %s\n", randomModel);
+	writer_printf(w, "c utilmodel = %s\n", correlation);
+	if (Rng == 1)
+		writer_printf(w, "c rng = xoshiro\n");
+	if (LatticeMode)
+		writer_printf(w, "c coarsen = block %d\n", 1 << level);
+	else
+		writer_printf(w, "c coarsen = matching %d\n", level);
+	for (i=0;i<n; i++){
+		if (res[i])
+			writer_printf(w, "c reserve %d\n", i);
+	}
+	writer_printf(w, "c \n");
+	writer_printf(w, "c \n");
+
+	writer_printf(w, "p %d %d\n", n, r);
+	for (i = 0; i < n; i++) {
+		writer_write(w, "n ", 2);
+		writer_int(w, i, ' ');
+		writer_int(w, res[i], ' ');
+		writer_int(w, util[i], ' ');
+		writer_int(w, cost[i], ' ');
+		writer_int(w, start[i+1] - start[i], ' ');
+		for(j = start[i]; j < start[i+1]; j++)
+			writer_int(w, adj[j], ' ');
+		writer_write(w, "\n", 1);
+	}
+	writer_close(w, NULL, NULL);
+	return(0);
+}
+
+
+/* Splits the parcels into Parts regions of nearly equal size with few
+   edges between them, for decomposition methods, and writes them to
+   OUTFILE.part. A lattice is cut by recursive coordinate bisection into
+   rectangles; a graph is partitioned by graph_partition() (multilevel, with
+   label propagation). The file gives the size of the cut, then for each
+   region its parcels, reserves, cost, utility and boundary parcels (those
+   with a neighbor in another region), then the region of each parcel. */
+int writePartition(char *outfile)
+{
+	char  partfile[MAX_NAME_LENGTH];
+	FILE  *fp;
+	int   *part, *size, *reserves, *boundary;
+	long long *cost, *util, cutArcs;
+	int   i, p, isBoundary, largest;
+	ARC   k;
+
+	if (Parts > N) error("--partition K needs at least K parcels.");
+	if (AdjStart == NULL)
+		buildLatticeAdj();
+	part = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	size = (int *)calloc(Parts, sizeof(int));
+	reserves = (int *)calloc(Parts, sizeof(int));
+	boundary = (int *)calloc(Parts, sizeof(int));
+	cost = (long long *)calloc(Parts, sizeof(long long));
+	util = (long long *)calloc(Parts, sizeof(long long));
+	if (part == NULL || size == NULL || reserves == NULL || boundary == NULL ||
+		cost == NULL || util == NULL)
+		error("out of memory.");
+
+	if (LatticeMode)
+		bisectLattice(0, Order, 0, Order, Parts, 0, part);
+	else if (graph_partition(N, AdjStart, Adj, Parts, part) != 0)
+		error("out of memory.");
+
+	cutArcs = 0;
+	for (i = 0; i < N; i++) {
+		p = part[i];
+		size[p]++;
+		reserves[p] += isReserve(i);
+		cost[p] += getAttr(&Cost, i);
+		util[p] += getAttr(&Util, i);
+		isBoundary = 0;
+		for (k = AdjStart[i]; k < AdjStart[i+1]; k++) {
+			if (part[Adj[k]] != p) {
+				cutArcs++;
+				isBoundary = 1;
+			}
+		}
+		boundary[p] += isBoundary;
+	}
+	largest = 0;
+	for (p = 0; p < Parts; p++) {
+		if (size[p] > largest) largest = size[p];
+	}
+
+	if (strlen(outfile) + 6 >= MAX_NAME_LENGTH) error("OUTFILE too long.");
+	sprintf(partfile, "%s.part", outfile);
+	fp = fopen(partfile, "w");
+	if (fp == NULL) error((char*)"partition file failed to open\n");
+	fprintf(fp, "c parcels split into regions by --partition %d (%s)\n", Parts,
+		LatticeMode ? "recursive coordinate bisection" : "multilevel label propagation");
+	fprintf(fp, "c s k n cut imbalance - k regions of n parcels, cut edges between regions,\n");
+	fprintf(fp, "c   largest region over the average size\n");
+	fprintf(fp, "s %d %d %lld %.4f\n", Parts, N, cutArcs / 2,
+		N > 0 ? (double)largest * Parts / N : 0.0);
+	fprintf(fp, "c r p parcels reserves cost utility boundary\n");
+	for (p = 0; p < Parts; p++) {
+		fprintf(fp, "r %d %d %d %lld %lld %d\n", p, size[p], reserves[p], cost[p],
+			util[p], boundary[p]);
+	}
+	fprintf(fp, "c a i p - parcel i is in region p\n");
+	for (i = 0; i < N; i++) {
+		fprintf(fp, "a %d %d\n", i, part[i]);
+	}
+	fclose(fp);
+	fprintf(stderr, "partition: %d regions, %lld cut edges, imbalance %.4f\n", Parts,
+		cutArcs / 2, N > 0 ? (double)largest * Parts / N : 0.0);
+
+	free(part);
+	free(size);
+	free(reserves);
+	free(boundary);
+	free(cost);
+	free(util);
+	return(0);
+}
+
+
+/* Assigns regions first ... first+k-1 to the rows r0..r1-1 and columns
+   c0..c1-1 of the lattice: the longer side is cut so that the two halves
+   get sizes in proportion to their numbers of regions, k/2 and k-k/2 */
+void bisectLattice(int r0, int r1, int c0, int c1, int k, int first, int *part)
+{
+	int i, j, k1, cut;
+
+	if (k == 1 || (r1 - r0) * (long long)(c1 - c0) <= 1) {
+		for (i = r0; i < r1; i++) {
+			for (j = c0; j < c1; j++)
+				part[i*Order+j] = first;
+		}
+		return;
+	}
+	k1 = k / 2;
+	if (r1 - r0 >= c1 - c0) {
+		cut = r0 + (int)(((long long)(r1 - r0) * k1 + k / 2) / k);
+		if (cut <= r0) cut = r0 + 1;
+		if (cut >= r1) cut = r1 - 1;
+		bisectLattice(r0, cut, c0, c1, k1, first, part);
+		bisectLattice(cut, r1, c0, c1, k - k1, first + k1, part);
+	}else {
+		cut = c0 + (int)(((long long)(c1 - c0) * k1 + k / 2) / k);
+		if (cut <= c0) cut = c0 + 1;
+		if (cut >= c1) cut = c1 - 1;
+		bisectLattice(r0, r1, c0, cut, k1, first, part);
+		bisectLattice(r0, r1, cut, c1, k - k1, first + k1, part);
+	}
+}
+
+
+/* 64-bit FNV-1a hash and size of a file */
+int hashFile(char *filename, unsigned long long *hash, long long *bytes)
+{
+	unsigned char buf[65536];
+	size_t n, k;
+	FILE *fp;
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL) error((char*)"hashFile failed to open file");
+	*hash = 0xcbf29ce484222325ULL;
+	*bytes = 0;
+	while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+		for (k = 0; k < n; k++) {
+			*hash ^= buf[k];
+			*hash *= 0x100000001b3ULL;
+		}
+		*bytes += n;
+	}
+	fclose(fp);
+	return(0);
+}
+
+
+typedef struct {
+	int index;
+	char *line;
+} MANIFESTENTRY;
+
+int cmpManifestEntry(const void *a, const void *b)
+{
+	const MANIFESTENTRY *ea = (const MANIFESTENTRY *)a;
+	const MANIFESTENTRY *eb = (const MANIFESTENTRY *)b;
+	if (ea->index > eb->index) return 1;
+	if (ea->index < eb->index) return -1;
+	return 0;
+}
+
+/* Combines shard manifests into one, ordered by instance index. All shards
+   must come from the same batch (same size, master seed and params), and
+   together they must cover every instance exactly once. */
+int mergeManifests(char *outmanifest, int nmanifests, char *manifests[])
+{
+	MANIFESTENTRY *entries = NULL;
+	int   nentries = 0;
+	int   capacity = 0;
+	int   total = -1;
+	int   instances, shard, shards, index;
+	int   i, missing, n;
+	unsigned long master = 0, master2;
+	char  *params = NULL;
+	FILE  *fp;
+
+	for (i = 0; i < nmanifests; i++) {
+		fp = fopen(manifests[i], "r");
+		if (fp == NULL) {
+			printf("%s ", manifests[i]);
+			error((char*)"manifest failed to open");
+		}
+		while (fgets(MyLinebuf, MAX_LINE_LENGTH, fp) != NULL) {
+			if (MyLinebuf[0] == 'm') {
+				if (sscanf(MyLinebuf, "m %d %lu %d %d", &instances, &master2, &shard, &shards) != 4)
+					error("bad manifest header.");
+				if (total < 0) {
+					total = instances;
+					master = master2;
+				}else if (total != instances || master != master2) {
+					printf("%s ", manifests[i]);
+					error("manifest belongs to a different batch.");
+				}
+			}else if (MyLinebuf[0] == 'i') {
+				n = 0;
+				if (sscanf(MyLinebuf, "i %d %*s %*s %*s %*s %n", &index, &n) != 1 || n == 0)
+					error("bad manifest entry.");
+				if (params == NULL)
+					params = strdup(MyLinebuf + n);
+				else if (strcmp(params, MyLinebuf + n) != 0) {
+					printf("%s ", manifests[i]);
+					error("manifest belongs to a batch with different params.");
+				}
+				if (nentries == capacity) {
+					capacity = capacity ? 2*capacity : 1024;
+					entries = (MANIFESTENTRY *)realloc(entries, sizeof(MANIFESTENTRY) * capacity);
+				}
+				entries[nentries].index = index;
+				entries[nentries].line = strdup(MyLinebuf);
+				nentries++;
+			}
+		}
+		fclose(fp);
+	}
+	if (total < 0) error("no manifest header found.");
+
+	qsort(entries, nentries, sizeof(MANIFESTENTRY), cmpManifestEntry);
+	missing = 0;
+	index = 0;
+	for (i = 0; i < nentries; i++) {
+		if (i > 0 && entries[i].index == entries[i-1].index) {
+			printf("instance %d ", entries[i].index);
+			error("appears in more than one manifest.");
+		}
+		if (entries[i].index < 0 || entries[i].index >= total) {
+			printf("instance %d ", entries[i].index);
+			error("out of range of the batch.");
+		}
+		for (; index < entries[i].index; index++) {
+			printf("missing instance %d\n", index);
+			missing++;
+		}
+		index = entries[i].index + 1;
+	}
+	for (; index < total; index++) {
+		printf("missing instance %d\n", index);
+		missing++;
+	}
+	if (missing > 0) error("manifests do not cover the batch.");
+
+	fp = fopen(outmanifest, "w");
+	if (fp == NULL) error((char*)"OUTMANIFEST failed to open\n");
+	fprintf(fp, "c corGenerator manifest\n");
+	fprintf(fp, "c m instances masterseed shard shards\n");
+	fprintf(fp, "c i index seed bytes fnv1a64 file params\n");
+	fprintf(fp, "m %d %lu %d %d\n", total, master, 0, 1);
+	for (i = 0; i < nentries; i++) {
+		fputs(entries[i].line, fp);
+		free(entries[i].line);
+	}
+	fclose(fp);
+	free(entries);
+	free(params);
+	fprintf(stderr, "merged %d instances into %s\n", nentries, outmanifest);
+	return(0);
+}
+
+
+/* Prints the index of an archive written with --output archive, in the
+   layout of a manifest with the offset of each instance in place of its
+   file */
+int listArchive(char *archivefile)
+{
+	ARCHIVE *a;
+	ARCHIVE_INFO info;
+	ARCHIVE_ENTRY_INFO e;
+	long long k;
+
+	a = archive_open(archivefile);
+	if (a == NULL) error((char*)"archive failed to open or is damaged\n");
+	archive_info(a, &info);
+	printf("c corGenerator archive %s\n", archivefile);
+	printf("c m instances masterseed shard shards\n");
+	printf("c i index seed bytes fnv1a64 offset\n");
+	printf("c params %.*s\n", (int)info.paramslength, info.params);
+	printf("m %llu %llu %llu %llu\n", info.instances, info.masterseed, info.shard, info.shards);
+	for (k = 0; k < archive_count(a); k++) {
+		if (archive_entry(a, k, &e) != 0) error("archive is damaged.");
+		printf("i %llu %llu %llu %016llx %llu\n", e.index, e.seed, e.length, e.hash, e.offset);
+	}
+	archive_close(a);
+	return(0);
+}
+
+
+/* Writes instance INDEX of an archive to OUTFILE.cor (standard output for
+   OUTFILE "-"), after checking its hash */
+int extractArchive(char *archivefile, char *indexstr, char *outfile)
+{
+	ARCHIVE *a;
+	ARCHIVE_ENTRY_INFO e;
+	WRITER *w;
+	const char *data;
+	unsigned long long index, hash;
+	size_t length, i;
+	long long k;
+
+	if (sscanf(indexstr, "%llu", &index) != 1)
+		error("wrong value for INDEX.");
+	a = archive_open(archivefile);
+	if (a == NULL) error((char*)"archive failed to open or is damaged\n");
+	k = archive_find(a, index);
+	if (k < 0) error("INDEX is not in the archive.");
+	archive_entry(a, k, &e);
+	data = archive_data(a, k, &length);
+	if (data == NULL) error("archive is damaged.");
+
+	hash = 0xcbf29ce484222325ULL;
+	for (i = 0; i < length; i++) {
+		hash ^= (unsigned char)data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	if (hash != e.hash) error("instance does not match its hash.");
+
+	if (strlen(outfile) + 5 >= MAX_NAME_LENGTH) error("OUTFILE too long.");
+	w = openCor(outfile, NULL);
+	writer_write(w, data, length);
+	writer_close(w, NULL, NULL);
+	if (writer_finish() != 0)
+		error("cannot write the cor file.");
+	archive_close(a);
+	return(0);
+}
+
+
+/* Reads the reserves (node ids in [0,N), separated by white space) and sets R */
+int readReserveFile(char *reservefile)
+{
+	FILE *fp;
+	int nodeid;
+
+	fp = fopen(reservefile, "r");
+	if (fp == NULL) error((char*)"RESERVEFILE failed to open file\n");
+	memset(Res, 0, N/8 + 1);
+	R = 0;
+	while (fscanf(fp, "%d", &nodeid) == 1) {
+		if (nodeid < 0 || nodeid >= N) {
+			printf("Reserve id %d. ", nodeid);
+			error((char*)"Reserve id out of bounds[0,N)\n");
+		}
+		if (!isReserve(nodeid)) R++;
+		setReserve(nodeid);
+	}
+	fclose(fp);
+	return(0);
+}
+
+
+////////
+
+/* slot of shuffle position pos in the hash table of setRandomReserves() */
+static int shuffleSlot(int *key, int cap, int pos)
+{
+	int h;
+
+	for (h = (int)((pos * 2654435761u) & (cap-1)); key[h] >= 0 && key[h] != pos; h = (h+1) & (cap-1)) ;
+	return(h);
+}
+
+/* Draws the random reserves by a partial Fisher-Yates shuffle of the
+   candidate parcels (all of them, or 1..N-2 for 2f+random). Only the shuffle
+   positions that were overwritten are stored, in a small hash table, so
+   memory is O(R) rather than O(N); the reserves are the same as with a full
+   array of candidates. */
+int setRandomReserves(char* randomModel){
+
+	int *key, *val;
+	int cap, h, g;
+	int i;
+	int resNum;
+	int first, count, draws;
+	int cand, last;
+
+	if ((strcmp(randomModel, "random")==0)){
+		first = 0;
+		count = N;
+		draws = R;
+	}else if ((strcmp(randomModel, "2f+random")==0)){
+		first = 1;
+		count = N-2;
+		draws = R-2;
+	}else{
+		error("unknown random model.\n");
+	}
+	for (cap = 16; cap < 4*draws; cap *= 2) ;
+	key = (int *)malloc(sizeof(int) * cap);
+	val = (int *)malloc(sizeof(int) * cap);
+	for (h = 0; h < cap; h++) key[h] = -1;
+
+	for (i=0; i<draws; i++) {
+		resNum = random() % (count-i);
+		// array[resNum] is a reserve, and is replaced by array[count-(i+1)]
+		h = shuffleSlot(key, cap, resNum);
+		cand = (key[h] == resNum) ? val[h] : first + resNum;
+		setReserve(cand);
+		g = shuffleSlot(key, cap, count-(i+1));
+		last = (key[g] == count-(i+1)) ? val[g] : first + count-(i+1);
+		key[h] = resNum;
+		val[h] = last;
+	}
+	free(key);
+	free(val);
+	return(0);
+}
+
+/* Adds reserve v and updates Dist, the hop distance of every parcel from the
+   nearest reserve (Spacing+1 standing for farther than Spacing), by a BFS
+   from v that only enters parcels it brings closer. Parcels that come to be
+   exactly Spacing hops away are appended to Ring. Each parcel gets closer at
+   most Spacing+1 times, so all the BFSs together take O(Spacing * edges) at
+   worst, and much less as the searches are cut off early. */
+static void addSpacedReserve(int v, int *dist, int *queue, int *ring, int *ringLen)
+{
+	int head, tail, u, w;
+	NBRITER it;
+
+	setReserve(v);
+	dist[v] = 0;
+	queue[0] = v;
+	head = 0;
+	tail = 1;
+	while (head < tail) {
+		u = queue[head++];
+		if (dist[u] >= Spacing) continue;
+		for (nbrBegin(u, &it); nbrNext(&it, &w); ) {
+			if (dist[w] <= dist[u] + 1) continue;
+			dist[w] = dist[u] + 1;
+			if (dist[w] == Spacing) ring[(*ringLen)++] = w;
+			queue[tail++] = w;
+		}
+	}
+}
+
+/* Draws the random reserves so that any two of them (the corners of
+   2f+random included) are at least Spacing hops apart, Poisson-disk style:
+   candidates are taken in random order and skipped if closer than Spacing
+   to a reserve. With --target-spacing each new reserve is drawn, when there
+   is one, among the parcels exactly Spacing hops from the nearest reserve,
+   so the reserves form a chain or net of that spacing. Fails if R reserves
+   cannot be placed. */
+int setSpacedReserves(char* randomModel){
+
+	int *dist, *queue, *ring, *perm;
+	int ringLen, placed, draws;
+	int first, count, next;
+	int i, k, v;
+
+	if (LatticeMode && AdjStart == NULL)
+		buildLatticeAdj();
+	if ((strcmp(randomModel, "random")==0)){
+		first = 0;
+		count = N;
+		draws = R;
+	}else if ((strcmp(randomModel, "2f+random")==0)){
+		first = 1;
+		count = N-2;
+		draws = R-2;
+	}else{
+		error("unknown random model.\n");
+	}
+
+	dist = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	queue = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	ring = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));	/* a parcel is Spacing hops away at most once */
+	perm = (int *)malloc(sizeof(int) * (count > 0 ? count : 1));
+	if (dist == NULL || queue == NULL || ring == NULL || perm == NULL) error("out of memory.");
+	for (i = 0; i < N; i++) dist[i] = Spacing + 1;
+	for (i = 0; i < count; i++) perm[i] = first + i;
+	ringLen = 0;
+	if (first == 1) {
+		addSpacedReserve(0, dist, queue, ring, &ringLen);
+		if (dist[N-1] < Spacing)
+			error("the fixed reserves of 2f+random are closer than the spacing.");
+		addSpacedReserve(N-1, dist, queue, ring, &ringLen);
+	}
+
+	next = 0;
+	for (placed = 0; placed < draws; placed++) {
+		v = -1;
+		// --target-spacing: a parcel of the ring that is still Spacing hops away
+		while (SpacingModel == SPACING_TARGET && v < 0 && ringLen > 0) {
+			k = random() % ringLen;
+			if (dist[ring[k]] == Spacing && !isReserve(ring[k]))
+				v = ring[k];
+			else
+				ring[k] = ring[--ringLen];
+		}
+		// otherwise the next parcel of a random order (partial Fisher-Yates) that is far enough
+		while (v < 0 && next < count) {
+			k = next + random() % (count - next);
+			v = perm[k];
+			perm[k] = perm[next];
+			perm[next++] = v;
+			if (dist[v] < Spacing || isReserve(v))
+				v = -1;
+		}
+		if (v < 0) {
+			fprintf(stderr, "placed %d of %d reserves\n", placed, draws);
+			error("cannot place the reserves with this spacing; pick a smaller H or R.");
+		}
+		addSpacedReserve(v, dist, queue, ring, &ringLen);
+	}
+	free(dist);
+	free(queue);
+	free(ring);
+	free(perm);
+	return(0);
+}
+
+/* Maps a whole file into memory (read only); returns NULL for an empty file */
+char *mapFile(char *filename, size_t *size)
+{
+	int fd;
+	struct stat st;
+	char *data;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) return(NULL);
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return(NULL);
+	}
+	data = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) return(NULL);
+	madvise(data, st.st_size, MADV_SEQUENTIAL);
+	*size = st.st_size;
+	return(data);
+}
+
+
+/* Reads a (possibly negative) integer at *p, skipping blanks but not newlines;
+   returns 0 if there is none before eol. Never reads past eol. */
+int scanInt(char **p, char *eol, int *value)
+{
+	char *q = *p;
+	long long v = 0;
+	int neg = 0;
+
+	while (q < eol && (*q == ' ' || *q == '\t' || *q == '\r')) q++;
+	if (q < eol && *q == '-') {
+		neg = 1;
+		q++;
+	}
+	if (q >= eol || *q < '0' || *q > '9') return(0);
+	while (q < eol && *q >= '0' && *q <= '9') {
+		v = 10*v + (*q - '0');
+		if (v > 2147483647LL) return(0);
+		q++;
+	}
+	*value = (int)(neg ? -v : v);
+	*p = q;
+	return(1);
+}
+
+
+/* CORFILE with the .cor extension added if it is missing */
+void corFileName(char *infile, char *corFile)
+{
+	if (strlen(infile) + 5 >= MAX_NAME_LENGTH) error("INFILE too long.");
+	strcpy(corFile, infile);
+	if (strlen(corFile) < 4 || strcmp(corFile + strlen(corFile) - 4, ".cor") != 0)
+		strcat(corFile, ".cor");
+}
+
+
+/* Picks up the generation parameters that the writers record in the
+   comments (l, d, terminalmodel, utilmodel, rng, Seed) */
+void scanCorComment(char *p, char *eol)
+{
+	size_t len = eol - p;
+
+	if (len >= MAX_LINE_LENGTH) return;
+	memcpy(MyLinebuf, p, len);
+	MyLinebuf[len] = '\0';
+	if (sscanf(MyLinebuf, "c l = %d", &L) == 1) return;
+	if (sscanf(MyLinebuf, "c d = %d", &D) == 1) return;
+	if (sscanf(MyLinebuf, "c Seed = %lu", &Seed) == 1) return;
+	if (sscanf(MyLinebuf, "c terminalmodel = %s", randomModel) == 1) return;
+	if (sscanf(MyLinebuf, "c utilmodel = %s", correlation) == 1) {
+		Corr = (strcmp(correlation, "weak") == 0);
+		return;
+	}
+	if (sscanf(MyLinebuf, "c rng = %s", MyStringbuf) == 1) {
+		Rng = (strcmp(MyStringbuf, "xoshiro") == 0);
+		return;
+	}
+	if (sscanf(MyLinebuf, "c spacing = %s %d", MyStringbuf, &Spacing) == 2)
+		SpacingModel = (strcmp(MyStringbuf, "target") == 0) ? SPACING_TARGET : SPACING_MIN;
+}
+
+
+/* Reads a corridor instance (see writeCor()) into N, R, Res, Util, Cost and
+   AdjStart/Adj. INFILE may be given with or without the .cor extension. The
+   file is memory-mapped and read in two passes: the first only reads the
+   degrees and value ranges, so that Adj is allocated with its exact size and
+   Cost and Util as narrow as possible. Node lines must come in order of id. */
+int readCorFile(char *infile){
+	char  corFile[MAX_NAME_LENGTH];
+	char  *data, *end, *p, *eol;
+	size_t size;
+	long long arcs;
+	long long line;
+	int   i, j;
+	int   nodes;
+	int   v[5];
+	long long minCost, maxCost, minUtil, maxUtil;
+
+	// read Corridor input file
+
+	corFileName(infile, corFile);
+	data = mapFile(corFile, &size);
+	if (data == NULL) error((char*)"Read_cor_file failed to open file");
+	end = data + size;
+
+	// first pass: the p line, the degrees and the generation parameters
+	N = -1;
+	nodes = 0;
+	arcs = 0;
+	line = 0;
+	minCost = minUtil = 0;
+	maxCost = maxUtil = 0;
+	for (p = data; p < end; p = eol + 1) {
+		eol = memchr(p, '\n', end - p);
+		if (eol == NULL) eol = end;
+		line++;
+		if (*p == 'c') {
+			scanCorComment(p, eol);
+		}else if (*p == 'p') {
+			p++;
+			if (N >= 0 || !scanInt(&p, eol, &N) || !scanInt(&p, eol, &R) || N < 0) {
+				printf("line %lld: ", line);
+				error("bad p line.");
+			}
+		}else if (*p == 'n') {
+			p++;
+			for (j = 0; j < 5; j++) {
+				if (!scanInt(&p, eol, &v[j])) break;
+			}
+			if (N < 0 || j < 5 || v[4] < 0 || nodes >= N) {
+				printf("line %lld: ", line);
+				error("bad node line.");
+			}
+			if (v[0] != nodes || (v[1] != 0 && v[1] != 1)) {
+				printf("line %lld: ", line);
+				error("node ids must be 0..n-1 in order, reserve flags 0 or 1.");
+			}
+			if (v[2] < minUtil) minUtil = v[2];
+			if (v[2] > maxUtil) maxUtil = v[2];
+			if (v[3] < minCost) minCost = v[3];
+			if (v[3] > maxCost) maxCost = v[3];
+			arcs += v[4];
+			nodes++;
+		}
+	}
+	if (N < 0) error("no p line.");
+	if (nodes != N) {
+		printf("%d node lines, %d nodes. ", nodes, N);
+		error("wrong number of node lines.");
+	}
+	if (arcs > ARC_MAX) error(TOO_MANY_ARCS);
+
+	allocAttr(&Cost, minCost, maxCost);
+	allocAttr(&Util, minUtil, maxUtil);
+	allocRes();
+	AdjStart = (ARC *)malloc(sizeof(ARC) * (N+1));
+	Adj = (int *)malloc(sizeof(int) * (arcs > 0 ? arcs : 1));
+	if (AdjStart == NULL || Adj == NULL) error("out of memory.");
+
+	// second pass: node lines
+	i = 0;
+	arcs = 0;
+	line = 0;
+	for (p = data; p < end && i < N; p = eol + 1) {
+		eol = memchr(p, '\n', end - p);
+		if (eol == NULL) eol = end;
+		line++;
+		if (*p != 'n') continue;
+		p++;
+		for (j = 0; j < 5; j++) {
+			scanInt(&p, eol, &v[j]);
+		}
+		if (v[1]) setReserve(i);
+		setAttr(&Util, i, v[2]);
+		setAttr(&Cost, i, v[3]);
+		AdjStart[i] = (ARC)arcs;
+		for (j = 0; j < v[4]; j++) {
+			if (!scanInt(&p, eol, &Adj[arcs])) {
+				printf("line %lld: ", line);
+				error("fewer neighbors than the degree.");
+			}
+			arcs++;
+		}
+		if (scanInt(&p, eol, &v[0])) {
+			printf("line %lld: ", line);
+			error("more neighbors than the degree.");
+		}
+		i++;
+	}
+	AdjStart[N] = (ARC)arcs;
+	munmap(data, size);
+	return(0);
+}
+
+
+/* 1 if every neighbor list holds the same ids as the list of parcels that
+   have it as a neighbor (multisets compared after sorting) */
+int isSymmetric(void)
+{
+	ARC *inStart, *fill;
+	int *inAdj, *sorted;
+	int i, j, v, d, maxDeg = 0;
+	NBRITER it;
+	int result = 1;
+
+	inStart = (ARC *)calloc(N+1, sizeof(ARC));
+	inAdj = (int *)malloc(sizeof(int) * (numArcs() > 0 ? numArcs() : 1));
+	fill = (ARC *)malloc(sizeof(ARC) * (N+1));
+
+	// transposed lists; filled in increasing order of i, so already sorted
+	for (i = 0; i < N; i++) {
+		d = nbrBegin(i, &it);
+		if (d > maxDeg) maxDeg = d;
+		while (nbrNext(&it, &v)) inStart[v+1]++;
+	}
+	for (i = 0; i < N; i++) inStart[i+1] += inStart[i];
+	for (i = 0; i < N; i++) fill[i] = inStart[i];
+	for (i = 0; i < N; i++) {
+		for (nbrBegin(i, &it); nbrNext(&it, &v); ) inAdj[fill[v]++] = i;
+	}
+
+	sorted = (int *)malloc(sizeof(int) * (maxDeg > 0 ? maxDeg : 1));
+	for (i = 0; i < N && result; i++) {
+		d = nbrBegin(i, &it);
+		if (inStart[i+1] - inStart[i] != d) {
+			result = 0;
+			break;
+		}
+		for (j = 0; nbrNext(&it, &v); j++) sorted[j] = v;
+		qsort(sorted, d, sizeof(int), cmpInt);
+		for (j = 0; j < d; j++) {
+			if (sorted[j] != inAdj[inStart[i] + j]) {
+				result = 0;
+				break;
+			}
+		}
+	}
+	free(inStart);
+	free(inAdj);
+	free(sorted);
+	free(fill);
+	return(result);
+}
+
+
+int cmpInt(const void *a, const void *b)
+{
+	int x = *(const int *)a;
+	int y = *(const int *)b;
+	return (x > y) - (x < y);
+}
+
+
+/* Labels the connected components 1, 2, ... in Status (breadth first, so
+   that deep graphs cannot overflow the stack); returns their number */
+int labelComponents(void)
+{
+	int *queue;
+	int head, tail;
+	int i, curr, nei;
+	NBRITER it;
+	int numComp = 0;
+
+	queue = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	for (i = 0; i < N; i++) {
+		Status[i] = 0;
+	}
+	for (i = 0; i < N; i++) {
+		if (Status[i] != 0) continue;
+		numComp++;
+		head = tail = 0;
+		queue[tail++] = i;
+		Status[i] = numComp;
+		while (head < tail) {
+			curr = queue[head++];
+			for (nbrBegin(curr, &it); nbrNext(&it, &nei); ) {
+				if (Status[nei] == 0) {
+					Status[nei] = numComp;
+					queue[tail++] = nei;
+				}
+			}
+		}
+	}
+	free(queue);
+	return(numComp);
+}
+
+
+/* Reports statistics of the instance read by readCorFile(); with validate,
+   also checks that it is well formed and exits with an error if not */
+int corStats(char *infile, int validate)
+{
+	long long costSum = 0, utilSum = 0, resCost = 0;
+	int i, v;
+	NBRITER it;
+	int cost, util;
+	int minDeg, maxDeg, minCost, maxCost, minUtil, maxUtil;
+	int numRes = 0, numComp, resComp = 0;
+	int problems = 0;
+
+	readCorFile(infile);
+	packAdjacency();
+	allocStatus();
+
+	minDeg = minCost = minUtil = 2147483647;
+	maxDeg = maxCost = maxUtil = -2147483647;
+	for (i = 0; i < N; i++) {
+		cost = getAttr(&Cost, i);
+		util = getAttr(&Util, i);
+		if (degree(i) < minDeg) minDeg = degree(i);
+		if (degree(i) > maxDeg) maxDeg = degree(i);
+		if (cost < minCost) minCost = cost;
+		if (cost > maxCost) maxCost = cost;
+		if (util < minUtil) minUtil = util;
+		if (util > maxUtil) maxUtil = util;
+		costSum += cost;
+		utilSum += util;
+		if (isReserve(i)) {
+			numRes++;
+			resCost += cost;
+		}
+		// ids out of range are errors in both modes, as labelComponents() follows them
+		for (nbrBegin(i, &it); nbrNext(&it, &v); ) {
+			if (v < 0 || v >= N) {
+				printf("node %d has neighbor %d out of [0,%d)\n", i, v, N);
+				problems++;
+			}else if (validate && v == i) {
+				printf("node %d is its own neighbor\n", i);
+				problems++;
+			}
+		}
+	}
+	if (problems > 0) error("invalid instance.");
+
+	numComp = labelComponents();
+	for (i = 0; i < N; i++) {
+		if (isReserve(i) && (resComp == 0 || Status[i] != resComp)) {
+			resComp = (resComp == 0) ? Status[i] : -1;
+			if (resComp < 0) break;
+		}
+	}
+
+	printf("n = %d\n", N);
+	printf("r = %d\n", R);
+	printf("edges = %lld\n", (long long)numArcs() / 2);
+	printf("degree min/avg/max = %d %.3f %d\n", N ? minDeg : 0,
+		N ? (double)numArcs() / N : 0.0, N ? maxDeg : 0);
+	printf("cost sum/min/max = %lld %d %d\n", costSum, N ? minCost : 0, N ? maxCost : 0);
+	printf("utility sum/min/max = %lld %d %d\n", utilSum, N ? minUtil : 0, N ? maxUtil : 0);
+	printf("reserves = %d\n", numRes);
+	printf("reserve cost = %lld\n", resCost);
+	printf("components = %d\n", numComp);
+	printf("reserves connected = %s\n", resComp >= 0 ? "yes" : "no");
+
+	if (validate) {
+		if (numRes != R) {
+			printf("p line says %d reserves, %d nodes are reserves\n", R, numRes);
+			problems++;
+		}
+		if (!isSymmetric()) {
+			printf("neighbor lists are not symmetric\n");
+			problems++;
+		}
+		if (problems > 0) error("invalid instance.");
+		printf("valid = yes\n");
+	}
+	return(0);
+}
+
+
+////
+
+
+
+///
+
+
+/* Loads the instance CORFILE once and, for every seed, regenerates the
+   requested fields (a comma separated list of costs, utilities and
+   reserves, or all) with the generation parameters recorded in its header.
+   Each variant is written to OUTFILE_seed.attr, which holds only the
+   attributes and refers to CORFILE for the graph. Regenerating all fields
+   with a seed gives the instance that generation with that SEED gives. */
+int resampleCor(char *infile, char *fieldlist, char *outfile, int nseeds, char *seeds[])
+{
+	char  corFile[MAX_NAME_LENGTH];
+	char  attrfile[MAX_NAME_LENGTH];
+	char  fieldbuf[MAX_NAME_LENGTH];
+	char  *field;
+	unsigned char *baseRes;
+	int   *baseCost, *baseUtil;
+	int   fields = 0;
+	int   i, k, variants = 0;
+	long long minCost, maxCost, minUtil, maxUtil;
+	unsigned long first, last, s;
+	unsigned long long hash;
+	long long bytes;
+
+	if (strlen(fieldlist) >= MAX_NAME_LENGTH) error("FIELDS too long.");
+	strcpy(fieldbuf, fieldlist);
+	for (field = strtok(fieldbuf, ","); field != NULL; field = strtok(NULL, ",")) {
+		if (strcmp(field, "costs") == 0) fields |= RESAMPLE_COSTS;
+		else if (strcmp(field, "utilities") == 0) fields |= RESAMPLE_UTILS;
+		else if (strcmp(field, "reserves") == 0) fields |= RESAMPLE_RESERVES;
+		else if (strcmp(field, "all") == 0) fields |= RESAMPLE_COSTS | RESAMPLE_UTILS | RESAMPLE_RESERVES;
+		else {
+			printf("%s ", field);
+			error("wrong field; use costs, utilities, reserves or all.");
+		}
+	}
+	if (fields == 0) error("no fields to resample.");
+	if (strlen(outfile) + 32 >= MAX_NAME_LENGTH) error("OUTFILE too long.");
+
+	corFileName(infile, corFile);
+	readCorFile(infile);
+
+	// the header must say how the requested fields were generated
+	if ((fields & (RESAMPLE_COSTS | RESAMPLE_UTILS)) && strcmp(correlation, "raster") == 0)
+		error("the costs and utilities of CORFILE were read from rasters and cannot be resampled.");
+	if ((fields & (RESAMPLE_COSTS | RESAMPLE_UTILS)) && L < 1)
+		error("CORFILE has no 'c l =' line.");
+	if ((fields & (RESAMPLE_COSTS | RESAMPLE_UTILS)) && correlation[0] == '\0')
+		error("CORFILE has no 'c utilmodel =' line.");
+	if ((fields & (RESAMPLE_COSTS | RESAMPLE_UTILS)) && Corr == 0 && D < 1)
+		error("for the uncorrelated model, D>=1.");
+	if (Corr == 1 && (fields & RESAMPLE_COSTS) && !(fields & RESAMPLE_UTILS))
+		error("in the weak model utilities depend on costs; resample costs,utilities.");
+	if (Corr == 1 && (fields & RESAMPLE_UTILS) && !(fields & RESAMPLE_COSTS))
+		error("in the weak model utilities depend on costs; resample costs,utilities.");
+	if (fields & RESAMPLE_RESERVES) {
+		if (strcmp(randomModel, "random") != 0 && strcmp(randomModel, "2f+random") != 0)
+			error("reserves can be resampled only for the random and 2f+random models.");
+		if (R > N || R < 0 || (strcmp(randomModel, "2f+random") == 0 && R < 2))
+			error("wrong value for R in CORFILE.");
+	}
+
+	// ReserveFree is not recorded; reserves cost 0 exactly when it was 1
+	ReserveFree = 0;
+	for (i = 0; i < N; i++) {
+		if (!isReserve(i)) continue;
+		if (getAttr(&Cost, i) != 0) {
+			ReserveFree = 0;
+			break;
+		}
+		ReserveFree = 1;
+	}
+	if (ReserveFree == 1 && (fields & RESAMPLE_RESERVES) && !(fields & RESAMPLE_COSTS))
+		error("reserves are free in CORFILE, so their costs change with them; resample reserves,costs.");
+
+	// the fields that are not resampled are restored from these copies
+	baseRes = (unsigned char *)malloc(N/8 + 1);
+	baseCost = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	baseUtil = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	if (baseRes == NULL || baseCost == NULL || baseUtil == NULL) error("out of memory.");
+	memcpy(baseRes, Res, N/8 + 1);
+	minCost = 0;
+	maxCost = L;
+	minUtil = (Corr == 0) ? 1 : -(long long)D;
+	maxUtil = (Corr == 0) ? D : (long long)L + D;
+	for (i = 0; i < N; i++) {
+		baseCost[i] = getAttr(&Cost, i);
+		baseUtil[i] = getAttr(&Util, i);
+		if (baseCost[i] < minCost) minCost = baseCost[i];
+		if (baseCost[i] > maxCost) maxCost = baseCost[i];
+		if (baseUtil[i] < minUtil) minUtil = baseUtil[i];
+		if (baseUtil[i] > maxUtil) maxUtil = baseUtil[i];
+	}
+	allocAttr(&Cost, minCost, maxCost);
+	allocAttr(&Util, minUtil, maxUtil);
+
+	hashFile(corFile, &hash, &bytes);
+
+	for (k = 0; k < nseeds; k++) {
+		if (sscanf(seeds[k], "%lu-%lu", &first, &last) != 2) {
+			if (sscanf(seeds[k], "%lu", &first) != 1) {
+				printf("%s ", seeds[k]);
+				error("wrong seed; use SEED or FIRST-LAST.");
+			}
+			last = first;
+		}
+		for (s = first; s >= first && s <= last; s++) {
+			Seed = s;
+			srandom(Seed);
+			memcpy(Res, baseRes, N/8 + 1);
+			if (fields & RESAMPLE_RESERVES)
+				drawReserves(randomModel);
+			if (fields & (RESAMPLE_COSTS | RESAMPLE_UTILS))
+				drawValues();
+			if (!(fields & RESAMPLE_COSTS))
+				setAttrBlock(&Cost, 0, baseCost, N);
+			if (!(fields & RESAMPLE_UTILS))
+				setAttrBlock(&Util, 0, baseUtil, N);
+
+			sprintf(attrfile, "%s_%lu.attr", outfile, s);
+			writeAttributes(attrfile, corFile, hash, fields);
+			variants++;
+		}
+	}
+	fprintf(stderr, "wrote %d variants of %s\n", variants, corFile);
+
+	free(baseRes);
+	free(baseCost);
+	free(baseUtil);
+	return(0);
+}
+
+
+/* Writes the reserves, utilities and costs of all parcels, one "a b u c"
+   line per parcel in the order of the ids of the topology corFile */
+int writeAttributes(char *attrfile, char *corFile, unsigned long long hash, int fields)
+{
 	FILE  *fp;
-	int   i, j;
-	int   n;
-	int   r;
-	int m;
-	int id;
-	int util;
-	int cost;
-	int nei;
-	int res;
-	char   first[1];
-	char  rest[MAX_LINE_LENGTH];
+	int   i;
+
+	fp = fopen(attrfile, "w");
+	if (fp == NULL) error((char*)"attribute file failed to open\n");
+
+	fprintf(fp, "c Corridor attributes\n");
+	fprintf(fp, "c topology = %s\n", corFile);
+	fprintf(fp, "c topology fnv1a64 = %016llx\n", hash);
+	fprintf(fp, "c fields =%s%s%s\n", (fields & RESAMPLE_COSTS) ? " costs" : "",
+		(fields & RESAMPLE_UTILS) ? " utilities" : "",
+		(fields & RESAMPLE_RESERVES) ? " reserves" : "");
+	fprintf(fp, "c Seed = %lu\n", Seed);
+	fprintf(fp, "c \n");
+	fprintf(fp, "c Format:\n");
+	fprintf(fp, "c p n r\n");
+	fprintf(fp, "c a b u c\n");
+	fprintf(fp, "c   one line for each node of the topology, in the order of the ids;\n");
+	fprintf(fp, "c   b whether the node is a reserve; b is 0 or 1; \n");
+	fprintf(fp, "c   u is the utility of the node; u is an integer; \n");
+	fprintf(fp, "c   c is the cost of the node; c is an integer; \n");
+	fprintf(fp, "c \n");
+	fprintf(fp, "c n = %d\n", N);
+	fprintf(fp, "c r = %d\n", R);
+	fprintf(fp, "c l = %d\n", L);
+	fprintf(fp, "c d = %d\n", D);
+	fprintf(fp, "c terminalmodel = %s\n", randomModel);
+	fprintf(fp, "c utilmodel = %s\n", correlation);
+	if (Rng == 1)
+		fprintf(fp, "c rng = xoshiro\n");
+	if (SpacingModel != SPACING_NONE)
+		fprintf(fp, "c spacing = %s %d\n", SpacingNames[SpacingModel], Spacing);
+	fprintf(fp, "c \n");
 
-	// read Corridor input file
+	fprintf(fp, "p %d %d\n", N, R);
+	for (i = 0; i < N; i++)
+		fprintf(fp, "a %d %d %d\n", isReserve(i), getAttr(&Util, i), getAttr(&Cost, i));
+	fclose(fp);
+	return(0);
+}
 
-	strcpy(corFile, infile);
-	strcat(corFile, ".cor");
-	fp = fopen(corFile, "r");
-	if (fp == NULL) error((char*)"Read_cor_file failed to open file");
 
-	fgets(MyLinebuf, MAX_LINE_LENGTH, fp);
+/* Uniform double in [0,1) from random() */
+double uniformDraw(void)
+{
+	return random() / ((double)RAND_MAX + 1);
+}
 
-	sscanf(MyLinebuf, "%s",first);
 
-	while (strcmp(first, "p")!=0) {
-		fgets(MyLinebuf, MAX_LINE_LENGTH, fp);
-		sscanf(MyLinebuf, "%s",first);
+/* Builds AdjStart/Adj for an Erdos-Renyi G(n,p) graph. Pairs i<j are
+   visited in lexicographic order and the gap to the next edge is drawn from
+   the geometric distribution, so the time is linear in n + edges; the lists
+   come out sorted because every list is filled in the order of the pairs. */
+int erdosRenyi(int n, double p)
+{
+	long long cap, m, k, i, j, pairs;
+	int *pair;
+	double r, lq, skip;
+
+	N = n;
+	cap = 1024;
+	m = 0;
+	pair = (int *)malloc(sizeof(int) * 2 * cap);
+	if (pair == NULL) error("out of memory.");
+	pairs = (long long)n * (n - 1) / 2;
+	lq = (p < 1) ? log(1 - p) : 0;
+	k = -1;
+	i = 0;
+	j = 0;
+	while (p > 0) {
+		if (p >= 1)
+			k++;
+		else {
+			r = uniformDraw();
+			skip = floor(log(1 - r) / lq);
+			if (skip >= (double)(pairs - k)) break;
+			k += 1 + (long long)skip;
+		}
+		if (k >= pairs) break;
+		// pair number k is (i,j), walking forward from the last pair
+		while (k >= i * (2LL * n - i - 1) / 2 + (n - 1 - i)) i++;
+		j = k - i * (2LL * n - i - 1) / 2 + i + 1;
+		if (m == cap) {
+			cap *= 2;
+			pair = (int *)realloc(pair, sizeof(int) * 2 * cap);
+			if (pair == NULL) error("out of memory.");
+		}
+		pair[2*m] = (int)i;
+		pair[2*m+1] = (int)j;
+		m++;
 	}
-	sscanf(MyLinebuf,"p %d %d\n",&N,&R);
-	//printf("n is %d;\nr is %d;\n",N,R);
+	pairsToAdj(m, pair);
+	free(pair);
+	return(0);
+}
 
-	allocCost();
-	allocStatus();
-	allocUtil();
-	allocRes();
-	allocNumNei();
-	allocId();
-	allocNeighbors();
 
-	int an;
-	for (i=0; i<N; i++){
-		fscanf(fp, "n %d %d %d %d %d",&id,&res,&util,&cost,&nei);
-		Id[i]=id;
-		Res[i]=res;
-
-
-		Util[i]=util;
-		Cost[i]=cost;
-		NumNei[i]=nei;
-		//      printf("n %d %d %d %d %d\n",id,res,util,cost,nei);
-		if (nei>0){
-			for (j=0; j<nei; j++){
-				fscanf(fp, "%d",&an);
-				Neighbors[i][j]=an;
-				//printf("neighbor is %d\n", an);
+/* Builds AdjStart/Adj for the N nodes and the m edges {pair[2k],pair[2k+1]};
+   every list holds its neighbors in the order of the pairs */
+int pairsToAdj(long long m, int *pair)
+{
+	long long k;
+	int i;
+	ARC *pos;
+
+	if (m > ARC_MAX / 2) error(TOO_MANY_ARCS);
+	AdjStart = (ARC *)calloc(N + 1, sizeof(ARC));
+	Adj = (int *)malloc(sizeof(int) * (m > 0 ? 2 * m : 1));
+	pos = (ARC *)malloc(sizeof(ARC) * (N > 0 ? N : 1));
+	if (AdjStart == NULL || Adj == NULL || pos == NULL) error("out of memory.");
+	for (k = 0; k < m; k++) {
+		AdjStart[pair[2*k]+1]++;
+		AdjStart[pair[2*k+1]+1]++;
+	}
+	for (i = 0; i < N; i++) {
+		AdjStart[i+1] += AdjStart[i];
+		pos[i] = AdjStart[i];
+	}
+	for (k = 0; k < m; k++) {
+		Adj[pos[pair[2*k]]++] = pair[2*k+1];
+		Adj[pos[pair[2*k+1]]++] = pair[2*k];
+	}
+	free(pos);
+	return(0);
+}
+
+
+/* Barabasi-Albert graph as networkx.barabasi_albert_graph builds it: a star
+   on nodes 0..m, then every new node is joined to m distinct nodes drawn
+   with probability proportional to their degree, i.e. uniformly from the
+   list of edge ends "repeated". Linear in n*m. */
+int barabasiAlbert(int n, int m)
+{
+	long long len, e, k;
+	int source, t, x;
+	int *repeated, *pair, *mark;
+
+	if (m < 1 || m >= n) error("wrong value for M; pick 1 <= M < NODES.");
+	N = n;
+	repeated = (int *)malloc(sizeof(int) * 2 * (long long)m * n);
+	pair = (int *)malloc(sizeof(int) * 2 * (long long)m * n);
+	mark = (int *)malloc(sizeof(int) * n);
+	if (repeated == NULL || pair == NULL || mark == NULL) error("out of memory.");
+	for (x = 0; x < n; x++) mark[x] = -1;
+
+	e = 0;
+	len = 0;
+	for (x = 1; x <= m; x++) {
+		pair[2*e] = 0;
+		pair[2*e+1] = x;
+		e++;
+		repeated[len++] = 0;
+	}
+	for (x = 1; x <= m; x++) repeated[len++] = x;
+
+	for (source = m + 1; source < n; source++) {
+		k = len;
+		for (t = 0; t < m; ) {
+			x = repeated[(long long)(uniformDraw() * k)];
+			if (mark[x] == source) continue;
+			mark[x] = source;
+			pair[2*e] = source;
+			pair[2*e+1] = x;
+			e++;
+			repeated[len++] = x;
+			t++;
+		}
+		for (t = 0; t < m; t++) repeated[len++] = source;
+	}
+	pairsToAdj(e, pair);
+	free(repeated);
+	free(pair);
+	free(mark);
+	return(0);
+}
+
+
+/* Appends b to the growing neighbor list of a */
+static void appendNeighbor(int **nbr, int *deg, int *size, int a, int b)
+{
+	if (deg[a] == size[a]) {
+		size[a] = size[a] ? 2 * size[a] : 4;
+		nbr[a] = (int *)realloc(nbr[a], sizeof(int) * size[a]);
+		if (nbr[a] == NULL) error("out of memory.");
+	}
+	nbr[a][deg[a]++] = b;
+}
+
+
+/* Holme-Kim power law graph with clustering, as in
+   networkx.powerlaw_cluster_graph: Barabasi-Albert growth from m isolated
+   nodes where, after each preferential edge, the next edge closes a
+   triangle with probability p (to a neighbor of the last target that is
+   not yet joined to the new node). The neighbor is found by scanning the
+   list of the target from a random position, so the choice is uniform
+   when no neighbor is excluded and the time stays close to linear. */
+int powerlawCluster(int n, int m, double p)
+{
+	long long len, e, k, cap;
+	int source, t, x, w, target, count, npicked, d, off;
+	int *repeated, *pair, *mark, *picked, *pick;
+	int *deg, *size, **nbr;
+
+	if (m < 1 || m >= n) error("wrong value for M; pick 1 <= M < NODES.");
+	if (p < 0 || p > 1) error("wrong value for P; pick 0 <= P <= 1.");
+	N = n;
+	cap = (long long)m * n;
+	repeated = (int *)malloc(sizeof(int) * 2 * cap);
+	pair = (int *)malloc(sizeof(int) * 2 * cap);
+	mark = (int *)malloc(sizeof(int) * n);
+	picked = (int *)malloc(sizeof(int) * n);
+	pick = (int *)malloc(sizeof(int) * m);
+	deg = (int *)calloc(n, sizeof(int));
+	size = (int *)calloc(n, sizeof(int));
+	nbr = (int **)calloc(n, sizeof(int *));
+	if (repeated == NULL || pair == NULL || mark == NULL || picked == NULL || pick == NULL ||
+		deg == NULL || size == NULL || nbr == NULL) error("out of memory.");
+	for (x = 0; x < n; x++) mark[x] = picked[x] = -1;
+
+	e = 0;
+	len = 0;
+	for (x = 0; x < m; x++) repeated[len++] = x;
+
+// joins source to y, once, and appends y to the preferential list
+#define JOIN(y) do { \
+	int y_ = (y); \
+	if (mark[y_] != source) { \
+		mark[y_] = source; \
+		pair[2*e] = source; \
+		pair[2*e+1] = y_; \
+		e++; \
+		appendNeighbor(nbr, deg, size, y_, source); \
+		appendNeighbor(nbr, deg, size, source, y_); \
+	} \
+	repeated[len++] = y_; \
+} while (0)
+
+	for (source = m; source < n; source++) {
+		k = len;
+		for (npicked = 0; npicked < m; ) {
+			x = repeated[(long long)(uniformDraw() * k)];
+			if (picked[x] == source) continue;
+			picked[x] = source;
+			pick[npicked++] = x;
+		}
+		target = pick[--npicked];
+		JOIN(target);
+		for (count = 1; count < m; count++) {
+			if (uniformDraw() < p && deg[target] > 0) {
+				d = deg[target];
+				off = (int)(uniformDraw() * d);
+				for (t = 0; t < d; t++) {
+					w = nbr[target][(off + t) % d];
+					if (w != source && mark[w] != source) break;
+				}
+				if (t < d) {
+					JOIN(w);
+					continue;
+				}
 			}
-			fscanf(fp, "\n");
+			target = pick[--npicked];
+			JOIN(target);
 		}
+		for (t = 0; t < m; t++) repeated[len++] = source;
 	}
-	checkNeighbors(NumNei, Neighbors);
-	fclose(fp);
+#undef JOIN
+
+	pairsToAdj(e, pair);
+	for (x = 0; x < n; x++) free(nbr[x]);
+	free(nbr);
+	free(size);
+	free(deg);
+	free(pick);
+	free(picked);
+	free(mark);
+	free(pair);
+	free(repeated);
 	return(0);
 }
 
 
-////
+/* Watts-Strogatz small world graph, as in networkx.watts_strogatz_graph: a
+   ring where every node is joined to its k/2 nearest nodes on each side,
+   then each ring edge {u,u+j} is replaced, with probability p, by {u,w}
+   for a random w that is not u and not yet a neighbor of u. The edges are
+   kept in a hash set, so every test and rewiring takes constant time. */
+#define WS_EMPTY (-1LL)
+#define WS_DELETED (-2LL)
 
+static long long *WSTable;
+static long long WSMask;
 
+static long long wsSlot(long long key, int insert)
+{
+	long long h, tomb = -1;
+
+	h = (long long)(((unsigned long long)key * 0x9E3779B97F4A7C15ULL) >> 17) & WSMask;
+	for (;; h = (h + 1) & WSMask) {
+		if (WSTable[h] == key) return(h);
+		if (WSTable[h] == WS_DELETED && tomb < 0) tomb = h;
+		if (WSTable[h] == WS_EMPTY) return(insert && tomb >= 0 ? tomb : h);
+	}
+}
+
+int wattsStrogatz(int n, int k, double p)
+{
+	long long m, s, size, key;
+	int h, j, u, v, w, ok;
+	int *pair, *deg;
+
+	if (k < 0 || k >= n) error("wrong value for K; pick 0 <= K < NODES.");
+	if (p < 0 || p > 1) error("wrong value for P; pick 0 <= P <= 1.");
+	N = n;
+	h = k / 2;
+	m = (long long)h * n;
+	for (size = 4; size < 4 * m; size *= 2) ;
+	WSTable = (long long *)malloc(sizeof(long long) * size);
+	pair = (int *)malloc(sizeof(int) * 2 * (m > 0 ? m : 1));
+	deg = (int *)malloc(sizeof(int) * n);
+	if (WSTable == NULL || pair == NULL || deg == NULL) error("out of memory.");
+	WSMask = size - 1;
+	for (s = 0; s < size; s++) WSTable[s] = WS_EMPTY;
+
+// key of the edge {a,b}
+#define WSKEY(a, b) ((a) < (b) ? (long long)(a) * n + (b) : (long long)(b) * n + (a))
+
+	for (j = 1; j <= h; j++)
+		for (u = 0; u < n; u++) {
+			v = (u + j) % n;
+			s = (long long)(j - 1) * n + u;
+			pair[2*s] = u;
+			pair[2*s+1] = v;
+			key = WSKEY(u, v);
+			WSTable[wsSlot(key, 1)] = key;
+		}
+	for (u = 0; u < n; u++) deg[u] = 2 * h;
+
+	for (j = 1; j <= h; j++)
+		for (u = 0; u < n; u++) {
+			if (uniformDraw() >= p) continue;
+			s = (long long)(j - 1) * n + u;
+			v = pair[2*s+1];
+			w = (int)(uniformDraw() * n);
+			ok = 1;
+			while (w == u || WSTable[wsSlot(WSKEY(u, w), 0)] != WS_EMPTY) {
+				w = (int)(uniformDraw() * n);
+				if (deg[u] >= n - 1) {
+					ok = 0;
+					break;
+				}
+			}
+			if (!ok) continue;
+			WSTable[wsSlot(WSKEY(u, v), 0)] = WS_DELETED;
+			key = WSKEY(u, w);
+			WSTable[wsSlot(key, 1)] = key;
+			pair[2*s+1] = w;
+			deg[v]--;
+			deg[w]++;
+		}
+#undef WSKEY
+
+	pairsToAdj(m, pair);
+	free(WSTable);
+	free(pair);
+	free(deg);
+	return(0);
+}
+
+
+/* Numbers the edges {i,j}, i<j, of AdjStart/Adj in the order of the lists:
+   edge e is {EdgeU[e],EdgeV[e]}, and the edges of node i come one after the
+   other. EdgeLower lists, for each node j, the edges {i,j} with i<j in
+   increasing order, so that the MPS columns of the nodes can be written
+   without sorting. An edge listed more than once (GML files may repeat
+   edges) is numbered once, so that the rows of the MIP have distinct names. */
+int numberEdges(void)
+{
+	int i, j;
+	ARC e;
+	ARC *pos;
+	int *seen;	/* seen[j] == i+1 once {i,j} is numbered */
+	NBRITER it;
+
+	NumEdges = 0;
+	EdgeLowerStart = (ARC *)calloc(N + 1, sizeof(ARC));
+	seen = (int *)calloc(N > 0 ? N : 1, sizeof(int));
+	if (EdgeLowerStart == NULL || seen == NULL) error("out of memory.");
+	for (i = 0; i < N; i++)
+		for (nbrBegin(i, &it); nbrNext(&it, &j); )
+			if (j > i && seen[j] != i+1) {
+				seen[j] = i+1;
+				EdgeLowerStart[j+1]++;
+				NumEdges++;
+			}
+	for (i = 0; i < N; i++)
+		EdgeLowerStart[i+1] += EdgeLowerStart[i];
+
+	EdgeU = (int *)malloc(sizeof(int) * (NumEdges > 0 ? NumEdges : 1));
+	EdgeV = (int *)malloc(sizeof(int) * (NumEdges > 0 ? NumEdges : 1));
+	EdgeLower = (ARC *)malloc(sizeof(ARC) * (NumEdges > 0 ? NumEdges : 1));
+	pos = (ARC *)malloc(sizeof(ARC) * (N > 0 ? N : 1));
+	if (EdgeU == NULL || EdgeV == NULL || EdgeLower == NULL || pos == NULL)
+		error("out of memory.");
+	memcpy(pos, EdgeLowerStart, sizeof(ARC) * N);
+	memset(seen, 0, sizeof(int) * (N > 0 ? N : 1));
+	e = 0;
+	for (i = 0; i < N; i++)
+		for (nbrBegin(i, &it); nbrNext(&it, &j); ) {
+			if (j <= i || seen[j] == i+1) continue;
+			seen[j] = i+1;
+			EdgeU[e] = i;
+			EdgeV[e] = j;
+			EdgeLower[pos[j]++] = e;
+			e++;
+		}
+	free(pos);
+	free(seen);
+	return(0);
+}
+
+
+/* Opens OUTFILE.lp or OUTFILE.mps (--mip-format), with a large buffer;
+   OUTFILE - is standard output */
+FILE *openMIPFile(char *outfile, char *mipfile)
+{
+	FILE  *fp;
+
+	if (strlen(outfile) + 8 >= MAX_NAME_LENGTH) error("OUTFILE too long.");
+	sprintf(mipfile, "%s.%s", outfile, MIPFormat == MIP_LP ? "lp" : "mps");
+	if (isStdout(outfile)) {
+		strcpy(mipfile, "standard output");
+		return(stdout);
+	}
+	fp = fopen(mipfile, "w");
+	if (fp == NULL) error((char*)"MIP file failed to open\n");
+	setvbuf(fp, MIPBuffer, _IOFBF, sizeof(MIPBuffer));
+	return(fp);
+}
+
+
+/* Numbers the edges and splits them: edge e is removable
+   (GispRemovable[e] = 1) with probability GispAlpha */
+int partitionEdges(void)
+{
+	ARC e;
+
+	numberEdges();
+	GispRemovable = (unsigned char *)malloc(NumEdges > 0 ? NumEdges : 1);
+	if (GispRemovable == NULL) error("out of memory.");
+	for (e = 0; e < NumEdges; e++)
+		GispRemovable[e] = (uniformDraw() < GispAlpha);
+	return(0);
+}
+
+
+/* Writes the GISP MIP of GISP/gisp.py in CPLEX LP format:
+     min  -w sum_i node_i + c sum_{removable ij} edge_i_j
+     s.t. node_i + node_j <= 1             (c_i_j) for the other edges
+          node_i + node_j - edge_i_j <= 1  (c_i_j) for the removable edges
+   with all variables binary */
+int writeGispLP(FILE *fp)
+{
+	int i, u, v, terms;
+	ARC e;
+
+	fprintf(fp, "Minimize\n obj:");
+	terms = 0;
+	for (i = 0; i < N; i++) {
+		fprintf(fp, " %s %.15g node_%d", NodeWeight >= 0 ? "-" : "+", fabs(NodeWeight), i + NodeBase);
+		if (++terms % 8 == 0) fprintf(fp, "\n");
+	}
+	for (e = 0; e < NumEdges; e++) {
+		if (!GispRemovable[e]) continue;
+		fprintf(fp, " %s %.15g edge_%d_%d", EdgeCost >= 0 ? "+" : "-", fabs(EdgeCost),
+			EdgeU[e] + NodeBase, EdgeV[e] + NodeBase);
+		if (++terms % 8 == 0) fprintf(fp, "\n");
+	}
+	fprintf(fp, "\nSubject To\n");
+	for (e = 0; e < NumEdges; e++) {
+		u = EdgeU[e] + NodeBase;
+		v = EdgeV[e] + NodeBase;
+		if (GispRemovable[e])
+			fprintf(fp, " c_%d_%d: node_%d + node_%d - edge_%d_%d <= 1\n", u, v, u, v, u, v);
+		else
+			fprintf(fp, " c_%d_%d: node_%d + node_%d <= 1\n", u, v, u, v);
+	}
+	fprintf(fp, "Binaries\n");
+	for (i = 0; i < N; i++)
+		fprintf(fp, " node_%d\n", i + NodeBase);
+	for (e = 0; e < NumEdges; e++)
+		if (GispRemovable[e])
+			fprintf(fp, " edge_%d_%d\n", EdgeU[e] + NodeBase, EdgeV[e] + NodeBase);
+	fprintf(fp, "End\n");
+	return(0);
+}
+
+
+/* Writes the same MIP in MPS format; the node columns list their rows in
+   increasing order (edges to lower nodes from EdgeLower, then their own) */
+int writeGispMPS(FILE *fp)
+{
+	int i;
+	ARC e, k, first;
+
+	fprintf(fp, "NAME          GISP\n");
+	fprintf(fp, "ROWS\n N  obj\n");
+	for (e = 0; e < NumEdges; e++)
+		fprintf(fp, " L  c_%d_%d\n", EdgeU[e] + NodeBase, EdgeV[e] + NodeBase);
+	fprintf(fp, "COLUMNS\n");
+	fprintf(fp, "    MARKER                 'MARKER'                 'INTORG'\n");
+	first = 0;
+	for (i = 0; i < N; i++) {
+		fprintf(fp, "    node_%d  obj  %.15g\n", i + NodeBase, -NodeWeight);
+		for (k = EdgeLowerStart[i]; k < EdgeLowerStart[i+1]; k++) {
+			e = EdgeLower[k];
+			fprintf(fp, "    node_%d  c_%d_%d  1\n", i + NodeBase, EdgeU[e] + NodeBase, EdgeV[e] + NodeBase);
+		}
+		for (e = first; e < NumEdges && EdgeU[e] == i; e++)
+			fprintf(fp, "    node_%d  c_%d_%d  1\n", i + NodeBase, i + NodeBase, EdgeV[e] + NodeBase);
+		first = e;
+	}
+	for (e = 0; e < NumEdges; e++) {
+		if (!GispRemovable[e]) continue;
+		fprintf(fp, "    edge_%d_%d  obj  %.15g\n", EdgeU[e] + NodeBase, EdgeV[e] + NodeBase, EdgeCost);
+		fprintf(fp, "    edge_%d_%d  c_%d_%d  -1\n", EdgeU[e] + NodeBase, EdgeV[e] + NodeBase,
+			EdgeU[e] + NodeBase, EdgeV[e] + NodeBase);
+	}
+	fprintf(fp, "    MARKER                 'MARKER'                 'INTEND'\n");
+	fprintf(fp, "RHS\n");
+	for (e = 0; e < NumEdges; e++)
+		fprintf(fp, "    RHS  c_%d_%d  1\n", EdgeU[e] + NodeBase, EdgeV[e] + NodeBase);
+	fprintf(fp, "BOUNDS\n");
+	for (i = 0; i < N; i++)
+		fprintf(fp, " BV BND  node_%d\n", i + NodeBase);
+	for (e = 0; e < NumEdges; e++)
+		if (GispRemovable[e])
+			fprintf(fp, " BV BND  edge_%d_%d\n", EdgeU[e] + NodeBase, EdgeV[e] + NodeBase);
+	fprintf(fp, "ENDATA\n");
+	return(0);
+}
 
-///
+
+/* Generates one GISP instance on AdjStart/Adj and streams it to
+   OUTFILE.lp or OUTFILE.mps (--mip-format); graph is the source of the
+   graph, recorded in the header with the other parameters */
+int generateGisp(char *outfile, char *graph)
+{
+	FILE  *fp;
+	char  mipfile[MAX_NAME_LENGTH];
+	char  *cmt;
+	long long removable;
+	ARC   e;
+
+	partitionEdges();
+	removable = 0;
+	for (e = 0; e < NumEdges; e++)
+		removable += GispRemovable[e];
+
+	fp = openMIPFile(outfile, mipfile);
+
+	cmt = (MIPFormat == MIP_LP) ? "\\" : "*";
+	fprintf(fp, "%s Generalized independent set problem, corEncoder version %s\n", cmt, version);
+	fprintf(fp, "%s graph = %s\n", cmt, graph);
+	fprintf(fp, "%s nodes = %d\n", cmt, N);
+	fprintf(fp, "%s edges = %lld\n", cmt, (long long)NumEdges);
+	fprintf(fp, "%s removable = %lld\n", cmt, removable);
+	fprintf(fp, "%s alpha = %.15g\n", cmt, GispAlpha);
+	fprintf(fp, "%s node weight = %.15g\n", cmt, NodeWeight);
+	fprintf(fp, "%s edge cost = %.15g\n", cmt, EdgeCost);
+	fprintf(fp, "%s Seed = %lu\n", cmt, Seed);
+	if (MIPFormat == MIP_LP)
+		writeGispLP(fp);
+	else
+		writeGispMPS(fp);
+	if (fclose(fp) != 0) error("cannot write the MIP file.");
+	fprintf(stderr, "wrote %s: %d nodes, %lld edges, %lld removable\n", mipfile, N, (long long)NumEdges, removable);
+	return(0);
+}
+
+
+/* Writes the minimum weight vertex cover MIP of MVC/generator_MVC.py in
+   CPLEX LP format: min sum_i w_i v_i s.t. v_i + v_j >= 1 (c_i_j) for every
+   edge, with binary variables */
+int writeMVCLP(FILE *fp)
+{
+	int i, u, v;
+	ARC e;
+
+	fprintf(fp, "Minimize\n obj:");
+	for (i = 0; i < N; i++) {
+		fprintf(fp, " + %.15g v%d", MVCWeight[i], i + NodeBase);
+		if ((i + 1) % 8 == 0) fprintf(fp, "\n");
+	}
+	fprintf(fp, "\nSubject To\n");
+	for (e = 0; e < NumEdges; e++) {
+		u = EdgeU[e] + NodeBase;
+		v = EdgeV[e] + NodeBase;
+		fprintf(fp, " c_%d_%d: v%d + v%d >= 1\n", u, v, u, v);
+	}
+	fprintf(fp, "Binaries\n");
+	for (i = 0; i < N; i++)
+		fprintf(fp, " v%d\n", i + NodeBase);
+	fprintf(fp, "End\n");
+	return(0);
+}
+
+
+/* Writes the same MIP in MPS format, columns as in writeGispMPS() */
+int writeMVCMPS(FILE *fp)
+{
+	int i;
+	ARC e, k, first;
+
+	fprintf(fp, "NAME          MVC\n");
+	fprintf(fp, "ROWS\n N  obj\n");
+	for (e = 0; e < NumEdges; e++)
+		fprintf(fp, " G  c_%d_%d\n", EdgeU[e] + NodeBase, EdgeV[e] + NodeBase);
+	fprintf(fp, "COLUMNS\n");
+	fprintf(fp, "    MARKER                 'MARKER'                 'INTORG'\n");
+	first = 0;
+	for (i = 0; i < N; i++) {
+		fprintf(fp, "    v%d  obj  %.15g\n", i + NodeBase, MVCWeight[i]);
+		for (k = EdgeLowerStart[i]; k < EdgeLowerStart[i+1]; k++) {
+			e = EdgeLower[k];
+			fprintf(fp, "    v%d  c_%d_%d  1\n", i + NodeBase, EdgeU[e] + NodeBase, EdgeV[e] + NodeBase);
+		}
+		for (e = first; e < NumEdges && EdgeU[e] == i; e++)
+			fprintf(fp, "    v%d  c_%d_%d  1\n", i + NodeBase, i + NodeBase, EdgeV[e] + NodeBase);
+		first = e;
+	}
+	fprintf(fp, "    MARKER                 'MARKER'                 'INTEND'\n");
+	fprintf(fp, "RHS\n");
+	for (e = 0; e < NumEdges; e++)
+		fprintf(fp, "    RHS  c_%d_%d  1\n", EdgeU[e] + NodeBase, EdgeV[e] + NodeBase);
+	fprintf(fp, "BOUNDS\n");
+	for (i = 0; i < N; i++)
+		fprintf(fp, " BV BND  v%d\n", i + NodeBase);
+	fprintf(fp, "ENDATA\n");
+	return(0);
+}
 
 
-int  checkNeighbors(int* NumNei, int ** Neighbors){
-	int i,j,k,m,nei;
+/* Draws the node weights of a vertex cover instance on AdjStart/Adj and
+   streams it to OUTFILE.lp or OUTFILE.mps; graph as in generateGisp() */
+int generateMVC(char *outfile, char *graph)
+{
+	FILE  *fp;
+	char  mipfile[MAX_NAME_LENGTH];
+	char  *cmt;
+	int   i;
+
+	numberEdges();
+	MVCWeight = (double *)malloc(sizeof(double) * (N > 0 ? N : 1));
+	if (MVCWeight == NULL) error("out of memory.");
+	for (i = 0; i < N; i++)
+		MVCWeight[i] = uniformDraw();
+
+	fp = openMIPFile(outfile, mipfile);
+	cmt = (MIPFormat == MIP_LP) ? "\\" : "*";
+	fprintf(fp, "%s Minimum weight vertex cover, corEncoder version %s\n", cmt, version);
+	fprintf(fp, "%s graph = %s\n", cmt, graph);
+	fprintf(fp, "%s nodes = %d\n", cmt, N);
+	fprintf(fp, "%s edges = %lld\n", cmt, (long long)NumEdges);
+	fprintf(fp, "%s weights = uniform [0,1)\n", cmt);
+	fprintf(fp, "%s Seed = %lu\n", cmt, Seed);
+	if (MIPFormat == MIP_LP)
+		writeMVCLP(fp);
+	else
+		writeMVCMPS(fp);
+	if (fclose(fp) != 0) error("cannot write the MIP file.");
+	fprintf(stderr, "wrote %s: %d nodes, %lld edges\n", mipfile, N, (long long)NumEdges);
+	return(0);
+}
+
+
+/* Reports the neighbors whose lists lack the reverse arc; returns how many */
+int  checkNeighbors(void){
+	int i,nei;
+	ARC j,m;
 	int flag=0;
+	int missing=0;
 	for (i=0; i< N; i++){
-		for (j=0; j< NumNei[i]; j++){
+		for (j=AdjStart[i]; j< AdjStart[i+1]; j++){
 			flag=0;
-			nei = Neighbors[i][j];
-			for(m=0;m<NumNei[nei];m++){
-				if(Neighbors[nei][m]==i){
+			nei = Adj[j];
+			for(m=AdjStart[nei];m<AdjStart[nei+1];m++){
+				if(Adj[m]==i){
 					flag=1;
 					break;
 				}
 			}
 			if (!flag) {
 				printf("Could not find %d as a neighbor of %d\n", i, nei);
+				missing++;
 			}
 		}
 	}
+	return(missing);
 }
 
 
 
 
-int dfsTop(int* Id, int* Status, int* NumNei, int** Neighbors){
+int dfsTop(int* Status){
 
 	int i;
 	int numComp=0;
@@ -814,7 +4464,7 @@ int dfsTop(int* Id, int* Status, int* NumNei, int** Neighbors){
 		if (Status[i]==0) {
 			numComp++;
 			printf("Component %d\n", numComp);
-			dfs(i, Id, Status,NumNei, Neighbors);
+			dfs(i, Status);
 			printf("\n\n");
 		}
 	}
@@ -829,44 +4479,534 @@ int dfsTop(int* Id, int* Status, int* NumNei, int** Neighbors){
 	return(1);
 }
 
-int dfs(int curr, int* Id,  int* Status, int* NumNei, int** Neighbors){
-	int i;
+int dfs(int curr, int* Status){
+	ARC i;
 	int nei;
 	//  cout << "DFS: Current Node " << curr << endl;
 	Status[curr]= 1; // very important - so that it is not 0
 	printf("%d ", curr);
 	// so that it is not processed again
-	for (i=0; i< NumNei[curr]; i++){
-		nei = Neighbors[curr][i];
+	for (i=AdjStart[curr]; i< AdjStart[curr+1]; i++){
+		nei = Adj[i];
 		if (Status[nei]==0) {
-			dfs(nei, Id, Status, NumNei, Neighbors);
+			dfs(nei, Status);
 		}
 	}
 	Status[curr]=2;
 	return(0);
 }
 
-////////////////////////////////
-void readGraph(FILE *fp){
-	NETWORK network;
-	if(read_network(&network, fp)!= 0)
+/* Reads GRAPHFILE in the format given by --graph-format, or guessed from its
+   extension. All formats are parsed in parallel straight into AdjStart/Adj.
+   With --graph-cache the checked lists are kept in the cache directory (see
+   graphcache.c), and later runs on the same file map them instead of parsing
+   it; the requests of serve find them in Resident */
+void readGraphFile(char *graphfile){
+	int format, r;
+	long long asymmetric = 0;
+
+	format = GraphFormat;
+	if (format < 0)
+		format = graph_format_from_extension(graphfile);
+	r = findResident(graphfile, format, 1);
+	if (r >= 0) {
+		N = Resident[r].n;
+		AdjStart = Resident[r].start;
+		Adj = Resident[r].adj;
+		GraphMapped = 1; // they belong to the worker
+		if (Resident[r].asymmetric > 0)
+			printf("%lld neighbors of %s have no reverse arc\n", Resident[r].asymmetric, graphfile);
+		fprintf(stderr, "read in neighbours kept by the server\n");
+		return;
+	}
+	if (loadGraph(graphfile, format, &asymmetric) != 0)
 		error("Error reading graph file.");
-	N = network.nvertices;
-	//store data in local data structures
-	allocNumNei();
-	int i,j;
-	Neighbors = (int **)malloc(sizeof(int *) * N);
+	if (GraphMapped) {
+		if (asymmetric > 0)
+			printf("%lld neighbors of %s have no reverse arc\n", asymmetric, graphfile);
+		fprintf(stderr, "read in neighbours from the cache\n");
+	}else
+		fprintf(stderr, "read in neighbours\n");
+}
+
+
+/* Reads GRAPHFILE in the given format into N, AdjStart and Adj, or maps
+   them from the graph cache; asymmetric is set to the number of neighbors
+   without a reverse arc. Returns 0, or 1 if the file cannot be read */
+int loadGraph(char *graphfile, int format, long long *asymmetric)
+{
+	GRAPH_CACHE_KEY key;
+
+	*asymmetric = 0;
+	if (GraphCache[0] != '\0') {
+		if (graph_cache_key(GraphCache, graphfile, format, &key) != 0)
+			return(1);
+		if (graph_cache_load(&key, &N, &AdjStart, &Adj, asymmetric) == 0) {
+			GraphMapped = 1;
+			graph_cache_free(&key);
+			return(0);
+		}
+	}
+	if (read_graph_file(graphfile, format, numThreads(), &N, &AdjStart, &Adj) != 0) {
+		if (GraphCache[0] != '\0')
+			graph_cache_free(&key);
+		return(1);
+	}
+	// only GML lists can be asymmetric (directed graphs)
+	if (format == GRAPH_GML)
+		*asymmetric = checkNeighbors();
+	if (GraphCache[0] != '\0') {
+		if (graph_cache_store(&key, N, AdjStart, Adj, *asymmetric) != 0)
+			fprintf(stderr, "warning: cannot write to the graph cache %s\n", GraphCache);
+		graph_cache_free(&key);
+	}
+	return(0);
+}
+
+
+/* Relabels the parcels in the order given by --reorder, before reserves,
+   costs and utilities are assigned. Reserves read from a file are relabeled
+   with them, and BFS order starts from one of them. The permutation goes to
+   OUTFILE.perm, where the line "v i j" means that parcel i is parcel j of
+   GRAPHFILE (as numbered without --reorder). */
+int reorderGraph(char *outfile)
+{
+	char  permfilename[MAX_NAME_LENGTH];
+	FILE  *fp;
+	ARC   *newStart;
+	int   *newAdj, *roots;
+	unsigned char *newRes;
+	int   i, before;
+	int   fileReserves;
+
+	if (isStdout(outfile)) error("--reorder cannot be used with OUTFILE -.");
+	fileReserves = (strcmp(randomModel, "file")==0);
+	roots = NULL;
+	if (fileReserves) {
+		roots = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+		for (i = 0; i < N; i++) {
+			roots[i] = isReserve(i);
+		}
+	}
+	Perm = (int *)malloc(sizeof(int) * (N > 0 ? N : 1));
+	before = graph_bandwidth(N, AdjStart, Adj);
+	if (graph_order(N, AdjStart, Adj, Reorder, roots, Perm) != 0)
+		error("reordering failed.");
+	free(roots);
+
+	newStart = (ARC *)malloc(sizeof(ARC) * (N+1));
+	newAdj = (int *)malloc(sizeof(int) * (AdjStart[N] > 0 ? AdjStart[N] : 1));
+	graph_permute(N, AdjStart, Adj, Perm, newStart, newAdj);
+	if (!GraphMapped) {
+		free(AdjStart);
+		free(Adj);
+	}
+	GraphMapped = 0;
+	AdjStart = newStart;
+	Adj = newAdj;
+	if (fileReserves) {
+		newRes = Res;
+		allocRes();
+		for (i = 0; i < N; i++) {
+			if ((newRes[Perm[i] >> 3] >> (Perm[i] & 7)) & 1)
+				setReserve(i);
+		}
+		free(newRes);
+	}
+	fprintf(stderr, "reorder %s: bandwidth %d -> %d\n", reorderModel,
+		before, graph_bandwidth(N, AdjStart, Adj));
+
+	if (strlen(outfile) + 6 >= MAX_NAME_LENGTH) error("OUTFILE too long.");
+	sprintf(permfilename, "%s.perm", outfile);
+	fp = fopen(permfilename, "w");
+	if (fp == NULL) error((char*)"permutation file failed to open\n");
+	fprintf(fp, "c parcels relabeled with --reorder %s\n", reorderModel);
+	fprintf(fp, "c v i j - parcel i of the instance is parcel j of the graph file\n");
+	for (i = 0; i < N; i++) {
+		fprintf(fp, "v %d %d\n", i, Perm[i]);
+	}
+	fclose(fp);
+	return(0);
+}
+
+
+/* Reads the costs and utilities of a raster instance. The rasters are cut
+   into blocks of Downsample x Downsample cells (smaller at the right and
+   bottom edges), read one strip of blocks at a time, and every block with a
+   cell that holds data in both rasters becomes a parcel whose cost and
+   utility are the means of those cells. The parcels are numbered row by
+   row and neighbor the parcels of the blocks above, to the left, to the
+   right and below, as in the lattice; blocks without data are holes. */
+int readRasters(char *costfile, char *utilfile)
+{
+	RASTER *cr, *ur;
+	RASTER_INFO ci, ui;
+	double *cstrip, *ustrip, *csum, *usum, *cmean, *umean;
+	int   *cells, *id;
+	long long blocks, s;
+	int   rows, i, j, b, cols;
+	int   crange[2], urange[2];
+	ARC   k;
+
+	cr = raster_open(costfile, &ci);
+	if (cr == NULL) error("COSTRASTER cannot be read.");
+	ur = raster_open(utilfile, &ui);
+	if (ur == NULL) error("UTILRASTER cannot be read.");
+	if (ci.rows != ui.rows || ci.cols != ui.cols)
+		error("COSTRASTER and UTILRASTER must have the same number of rows and columns.");
+	cols = ci.cols;
+	RasterRows = (ci.rows + Downsample - 1) / Downsample;
+	RasterCols = (cols + Downsample - 1) / Downsample;
+	blocks = (long long)RasterRows * RasterCols;
+	if (blocks > INT_MAX)
+		error("too many parcels; pick a larger --downsample.");
+
+	cstrip = (double *)malloc(sizeof(double) * Downsample * (size_t)cols);
+	ustrip = (double *)malloc(sizeof(double) * Downsample * (size_t)cols);
+	csum = (double *)malloc(sizeof(double) * RasterCols);
+	usum = (double *)malloc(sizeof(double) * RasterCols);
+	cells = (int *)malloc(sizeof(int) * RasterCols);
+	cmean = (double *)malloc(sizeof(double) * blocks);
+	umean = (double *)malloc(sizeof(double) * blocks);
+	id = (int *)malloc(sizeof(int) * blocks);
+	if (cstrip == NULL || ustrip == NULL || csum == NULL || usum == NULL ||
+		cells == NULL || cmean == NULL || umean == NULL || id == NULL)
+		error("out of memory.");
+
+	N = 0;
+	for (i = 0; i < RasterRows; i++) {
+		rows = (ci.rows - i*Downsample < Downsample) ? ci.rows - i*Downsample : Downsample;
+		if (raster_read(cr, rows, cstrip) != 0) error("COSTRASTER cannot be read.");
+		if (raster_read(ur, rows, ustrip) != 0) error("UTILRASTER cannot be read.");
+		for (j = 0; j < RasterCols; j++) {
+			csum[j] = usum[j] = 0;
+			cells[j] = 0;
+		}
+		for (s = 0; s < (long long)rows * cols; s++) {
+			if (isnan(cstrip[s]) || isnan(ustrip[s])) continue;
+			j = (int)(s % cols) / Downsample;
+			csum[j] += cstrip[s];
+			usum[j] += ustrip[s];
+			cells[j]++;
+		}
+		for (j = 0; j < RasterCols; j++) {
+			b = i*RasterCols + j;
+			id[b] = -1;
+			if (cells[j] == 0) continue;
+			id[b] = N;
+			cmean[N] = csum[j] / cells[j];
+			umean[N] = usum[j] / cells[j];
+			N++;
+		}
+	}
+	raster_close(cr);
+	raster_close(ur);
+	free(cstrip);
+	free(ustrip);
+	free(csum);
+	free(usum);
+	free(cells);
+	if (N == 0) error("the rasters have no cells with data.");
+
+	RasterCost = (int *)malloc(sizeof(int) * N);
+	RasterUtil = (int *)malloc(sizeof(int) * N);
+	RasterBlock = (int *)malloc(sizeof(int) * N);
+	if (4LL * N > ARC_MAX) error(TOO_MANY_ARCS);
+	AdjStart = (ARC *)malloc(sizeof(ARC) * (N+1));
+	Adj = (int *)malloc(sizeof(int) * 4 * (size_t)N);
+	if (RasterCost == NULL || RasterUtil == NULL || RasterBlock == NULL ||
+		AdjStart == NULL || Adj == NULL)
+		error("out of memory.");
+	rescaleRaster(cmean, N, L, RasterCost, crange, "COSTRASTER");
+	rescaleRaster(umean, N, D, RasterUtil, urange, "UTILRASTER");
+	free(cmean);
+	free(umean);
+
+	k = 0;
+	for (i = 0; i < RasterRows; i++) {
+		for (j = 0; j < RasterCols; j++) {
+			b = i*RasterCols + j;
+			if (id[b] < 0) continue;
+			RasterBlock[id[b]] = b;
+			AdjStart[id[b]] = k;
+			if (i > 0 && id[b-RasterCols] >= 0) Adj[k++] = id[b-RasterCols];
+			if (j > 0 && id[b-1] >= 0) Adj[k++] = id[b-1];
+			if (j < RasterCols-1 && id[b+1] >= 0) Adj[k++] = id[b+1];
+			if (i < RasterRows-1 && id[b+RasterCols] >= 0) Adj[k++] = id[b+RasterCols];
+		}
+	}
+	AdjStart[N] = k;
+	free(id);
+
+	/* costs are 0 for free reserves */
+	allocAttr(&Cost, (crange[0] < 0) ? crange[0] : 0, crange[1]);
+	allocAttr(&Util, urange[0], urange[1]);
+	fprintf(stderr, "raster: %d x %d cells, %d x %d blocks, %d parcels\n",
+		ci.rows, cols, RasterRows, RasterCols, N);
+	return(0);
+}
+
+
+/* Rounds the block means mean[0..n-1] to integer values: rescaled linearly
+   from their range to [1,hi], or as they are for hi = 0. The smallest and
+   largest value go to range[0] and range[1]. */
+void rescaleRaster(double *mean, int n, int hi, int *value, int range[2], char *name)
+{
+	double lo = mean[0], top = mean[0];
+	int i;
+
+	for (i = 1; i < n; i++) {
+		if (mean[i] < lo) lo = mean[i];
+		if (mean[i] > top) top = mean[i];
+	}
+	if (hi == 0 && (lo < INT_MIN || top > INT_MAX)) {
+		printf("%s ", name);
+		error("values do not fit in an integer; pick a range to rescale them to.");
+	}
+	for (i = 0; i < n; i++) {
+		if (hi == 0)
+			value[i] = (int)floor(mean[i] + 0.5);
+		else if (top > lo)
+			value[i] = 1 + (int)floor((mean[i] - lo) / (top - lo) * (hi - 1) + 0.5);
+		else
+			value[i] = 1;
+		if (i == 0 || value[i] < range[0]) range[0] = value[i];
+		if (i == 0 || value[i] > range[1]) range[1] = value[i];
+	}
+}
+
+
+/* Writes the block of the rasters of each parcel to OUTFILE.cells, where
+   the line "v i row col" means that parcel i is the block of cells
+   row*F ... row*F+F-1 and col*F ... col*F+F-1 for --downsample F */
+int writeRasterBlocks(char *outfile, char *costfile, char *utilfile)
+{
+	char  cellsfilename[MAX_NAME_LENGTH];
+	FILE  *fp;
+	int   i;
+
+	if (strlen(outfile) + 7 >= MAX_NAME_LENGTH) error("OUTFILE too long.");
+	sprintf(cellsfilename, "%s.cells", outfile);
+	fp = fopen(cellsfilename, "w");
+	if (fp == NULL) error((char*)"cells file failed to open\n");
+	fprintf(fp, "c parcels of the rasters %s and %s\n", costfile, utilfile);
+	fprintf(fp, "c s rows cols downsample - blocks per column and per row, and cells per side of a block\n");
+	fprintf(fp, "c v i row col - parcel i of the instance is the block in row row and column col\n");
+	fprintf(fp, "s %d %d %d\n", RasterRows, RasterCols, Downsample);
 	for (i = 0; i < N; i++) {
-		NumNei[i] = network.vertex[i].degree;
-		Neighbors[i] = (int *)malloc(sizeof(int) * NumNei[i] );
-		for(j=0; j < network.vertex[i].degree; j++)
-			Neighbors[i][j] = network.vertex[i].edge[j].target;
+		fprintf(fp, "v %d %d %d\n", i, RasterBlock[i] / RasterCols, RasterBlock[i] % RasterCols);
+	}
+	fclose(fp);
+	return(0);
+}
+
+
+/* With --adjacency packed, replaces AdjStart and Adj by the neighbor lists
+   packed by adjpack.c, which take 2 to 3 times less memory on sparse graphs;
+   the writers, reserve placement, statistics and MIP builders go through
+   nbrBegin() and nbrNext(), and see the same lists in the same order */
+int packAdjacency(void)
+{
+	size_t arrays;
+
+	if (!PackAdjacency || AdjStart == NULL) return(0);
+	if (Features != FEATURES_NONE || Bipartite || NumSolutions > 0 || Coarsen > 0 || Parts > 0)
+		error("--features, --bipartite, --solution, --coarsen and --partition cannot be used with --adjacency packed.");
+	arrays = sizeof(ARC) * ((size_t)N + 1) + sizeof(int) * (size_t)AdjStart[N];
+	Packed = adjpack_build(N, AdjStart, Adj);
+	if (Packed == NULL) error("out of memory.");
+	if (!GraphMapped) {
+		free(AdjStart);
+		free(Adj);
+	}
+	GraphMapped = 0;
+	AdjStart = NULL;
+	Adj = NULL;
+	fprintf(stderr, "packed adjacency: %zu bytes (%zu as arrays)\n", adjpack_size(Packed), arrays);
+	return(0);
+}
+
+
+int numThreads(void)
+{
+	long n;
+
+	if (Threads > 0)
+		return(Threads);
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+	return(n > 0 ? (int)n : 1);
+}
+
+
+/* Returns the entry of Resident that holds GRAPHFILE read in the given
+   format, or -1; with current, only if the file has not changed since */
+int findResident(char *graphfile, int format, int current)
+{
+	int r;
+	struct stat st;
+
+	for (r = 0; r < NumResident; r++) {
+		if (Resident[r].name == NULL || Resident[r].format != format ||
+			strcmp(Resident[r].name, graphfile) != 0)
+			continue;
+		if (!current)
+			return(r);
+		if (stat(graphfile, &st) != 0 || (long long)st.st_size != Resident[r].size ||
+			(long long)st.st_mtim.tv_sec != Resident[r].mtime ||
+			(long long)st.st_mtim.tv_nsec != Resident[r].mtimensec)
+			return(-1);
+		return(r);
+	}
+	return(-1);
+}
+
+
+/* Reads the GRAPHFILE of a request of serve (graph, gisp graph or mvc
+   graph) into Resident, unless it is there already. A file that cannot be
+   read is left to the request, which reports the error */
+void keepResident(int argc, char *argv[])
+{
+	char *posv[MAX_ARGS];
+	char *graphfile = NULL;
+	int posc = 0, format = GraphFormat, i, r;
+	long long asymmetric;
+	struct stat st;
+
+	for (i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--", 2) == 0) {
+			if (i+1 < argc && strcmp(argv[i], "--graph-format") == 0)
+				format = graph_format_from_name(argv[i+1]);
+			i++;
+			continue;
+		}
+		posv[posc++] = argv[i];
+	}
+	if (posc >= 2 && strcmp(posv[0], "graph") == 0)
+		graphfile = posv[1];
+	else if (posc >= 3 && (strcmp(posv[0], "gisp") == 0 || strcmp(posv[0], "mvc") == 0) &&
+		strcmp(posv[1], "graph") == 0)
+		graphfile = posv[2];
+	if (graphfile == NULL)
+		return;
+	if (format < 0)
+		format = graph_format_from_extension(graphfile);
+	if (findResident(graphfile, format, 1) >= 0 || stat(graphfile, &st) != 0)
+		return;
+
+	// the entry of an older copy of the file, a free one, or the oldest one
+	r = findResident(graphfile, format, 0);
+	if (r < 0 && NumResident < MAX_RESIDENT)
+		r = NumResident++;
+	else {
+		if (r < 0) {
+			r = NextResident;
+			NextResident = (NextResident + 1) % MAX_RESIDENT;
+		}
+		free(Resident[r].name);
+		if (!Resident[r].mapped) {
+			free(Resident[r].start);
+			free(Resident[r].adj);
+		}
+	}
+	Resident[r].name = NULL;
+	Resident[r].start = NULL;
+	Resident[r].adj = NULL;
+	Resident[r].mapped = 0;
+
+	GraphMapped = 0;
+	if (loadGraph(graphfile, format, &asymmetric) == 0) {
+		Resident[r].name = malloc(strlen(graphfile) + 1);
+		if (Resident[r].name == NULL) error("out of memory.");
+		strcpy(Resident[r].name, graphfile);
+		Resident[r].format = format;
+		Resident[r].size = (long long)st.st_size;
+		Resident[r].mtime = (long long)st.st_mtim.tv_sec;
+		Resident[r].mtimensec = (long long)st.st_mtim.tv_nsec;
+		Resident[r].n = N;
+		Resident[r].start = AdjStart;
+		Resident[r].adj = Adj;
+		Resident[r].mapped = GraphMapped;
+		Resident[r].asymmetric = asymmetric;
+		fprintf(stderr, "worker %ld keeps %s: %d parcels\n", (long)getpid(), graphfile, N);
+	}
+	// the requests start without a graph, as a command line does
+	N = 0;
+	AdjStart = NULL;
+	Adj = NULL;
+	GraphMapped = 0;
+}
+
+
+/* Serves requests on the Unix domain socket SOCKET with Workers worker
+   processes (see server.c), until the server is stopped */
+int serve(char *socketpath)
+{
+	int fd, workers;
+
+	Serving = 1;
+	workers = Workers;
+	if (workers < 1) {
+		workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+		if (workers < 1) workers = 1;
+	}
+	fd = server_listen(socketpath);
+	if (fd < 0) {
+		printf("%s ", socketpath);
+		error("cannot listen on this socket; is another server using it?");
 	}
-	checkNeighbors(NumNei, Neighbors);
-	fprintf(stderr, "read in neighbours\n");
-	free_network(&network);
+	fprintf(stderr, "serving on %s with %d workers\n", socketpath, workers);
+	if (server_run(fd, socketpath, workers, serveRequest, NULL) != 0)
+		error("cannot start the workers.");
+	fprintf(stderr, "server stopped\n");
+	return(0);
 }
 
 
+/* Runs one request of serve: its arguments are those of a command line,
+   separated by blanks. The command runs in a child process with standard
+   output on body, so that its globals, its exit on errors and its memory
+   end with the request; the graph is kept by the worker (keepResident())
+   and shared with the child until either writes to it. Returns the exit
+   status of the command */
+int serveRequest(void *data, char *line, int body)
+{
+	char *argv[MAX_ARGS];
+	char *p;
+	int argc = 0, status;
+	pid_t pid;
+
+	argv[argc++] = execname;
+	for (p = strtok(line, " \t"); p != NULL; p = strtok(NULL, " \t")) {
+		if (argc >= MAX_ARGS) {
+			dprintf(body, "too many arguments.\n");
+			return(1);
+		}
+		argv[argc++] = p;
+	}
+	if (argc <= 1) {
+		dprintf(body, "Bad arguments\n");
+		return(1);
+	}
+	keepResident(argc, argv);
+
+	fflush(stdout);
+	fflush(stderr);
+	pid = fork();
+	if (pid < 0) {
+		dprintf(body, "cannot start the request.\n");
+		return(1);
+	}
+	if (pid == 0) {
+		dup2(body, 1);
+		exit(runCommand(argc, argv));
+	}
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR) return(1);
+	}
+	if (WIFEXITED(status))
+		return(WEXITSTATUS(status));
+	dprintf(body, "the request was stopped by signal %d.\n", WTERMSIG(status));
+	return(1);
+}
 
 ///////////////////////////////////
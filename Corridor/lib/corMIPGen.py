@@ -7,6 +7,7 @@ import os
 import gurobipy as grb
 import argparse
 import networkx as nx
+import numpy as np
 from IPython import embed
 
 grb.setParam("LogFile","")
@@ -14,11 +15,15 @@ grb.setParam("LogToConsole",0)
 
 parser = argparse.ArgumentParser()
 parser.add_argument('--cor_file', required=True,
-                    help=".cor file to use for MIP instance")
+                    help=".cor file to use for MIP instance, or a .cora archive written by corGenerator --output archive")
+parser.add_argument('--index', default=None, type=int,
+                    help="index of the instance to use if --cor_file is an archive")
 parser.add_argument('--budget_frac', required=True, type=float,
                     help="fraction of total cost allowed for budget")
 parser.add_argument('--out_file', required=True,
                     help=".mps file to output to")
+parser.add_argument('--attr_file', default=None,
+                    help=".attr file with the reserves, utilities and costs to use instead of those of the .cor file")
 
 
 def parseCor(corlat_instance):
@@ -32,12 +37,19 @@ def parseCor(corlat_instance):
 
     """
     assert os.path.exists(corlat_instance), "{} does not exist".format(corlat_instance)
+    with open(corlat_instance, "r") as f:
+        return parseCorLines(f.readlines())
+
+
+def parseCorLines(lines):
+    """parses the lines of a corlat instance in .cor format, as parseCor does"""
     graph = nx.digraph.DiGraph()
     edges = []
-    with open(corlat_instance, "r") as f:
-        raw_data = list(map(lambda x:x.strip(), f.readlines()))
+    raw_data = list(map(lambda x:x.strip(), lines))
 
     for row in raw_data:
+        if not row:
+            continue
         row_type = row[0]
         if row_type == "p":
             # p n r
@@ -58,7 +70,7 @@ def parseCor(corlat_instance):
             node_id, is_reserve, node_utility, node_cost, num_neighbors = map(int, split_row[1:6])
 
             # get neighbors
-            neighbors = list(map(int, split_row[6:-1]))
+            neighbors = list(map(int, split_row[6:6+num_neighbors]))
             edges += [(node_id, neighbor_id) for neighbor_id in neighbors]
             edges += [(neighbor_id, node_id) for neighbor_id in neighbors]
             graph.add_node(node_id, is_reserve=is_reserve,
@@ -69,6 +81,96 @@ def parseCor(corlat_instance):
     return graph
 
 
+def parseCorAttributes(graph, attr_file):
+    """replaces the reserves, utilities and costs of a parsed corlat instance by those of an .attr file
+
+    Args:
+        graph: graph returned by parseCor for the topology the .attr file refers to
+        attr_file: file path of the .attr file written by "corGenerator resample"
+
+    Returns:
+        the same graph, with updated node attributes
+
+    """
+    assert os.path.exists(attr_file), "{} does not exist".format(attr_file)
+    node_id = 0
+    with open(attr_file, "r") as f:
+        for row in f:
+            split_row = row.split()
+            if not split_row or split_row[0] != "a":
+                continue
+            # a b u c
+            is_reserve, node_utility, node_cost = map(int, split_row[1:4])
+            graph.nodes[node_id].update(is_reserve=is_reserve,
+                node_utility=node_utility, node_cost=node_cost)
+            node_id += 1
+    assert node_id == graph.number_of_nodes(), "{} has {} nodes, the graph {}".format(
+        attr_file, node_id, graph.number_of_nodes())
+    return graph
+
+
+def readBipartite(bip_file):
+    """reads the variable-constraint bipartite graph written by corGenerator --bipartite
+
+    Args:
+        bip_file: file path of the .bip file
+
+    Returns:
+        a dict of memory-mapped arrays: edge_index (2 x nnz, constraint and variable of each nonzero),
+        coef (nnz), var_features (nvars x 4: obj, binary, lb, ub) and con_features (ncons x 2: rhs, sense)
+
+    """
+    data = np.memmap(bip_file, dtype="<i8", mode="r")
+    assert data[:1].tobytes() == b"CORBIP01", "{} is not a bipartite graph file".format(bip_file)
+    nvars, ncons, nnz, var_dim, con_dim = map(int, data[1:6])
+    offset = 8
+    edge_index = data[offset:offset+2*nnz].reshape(2, nnz)
+    offset += 2*nnz
+    coef = data[offset:offset+nnz].view("<f8")
+    offset += nnz
+    var_features = data[offset:offset+nvars*var_dim].view("<f8").reshape(nvars, var_dim)
+    offset += nvars*var_dim
+    con_features = data[offset:offset+ncons*con_dim].view("<f8").reshape(ncons, con_dim)
+    return {"edge_index": edge_index, "coef": coef,
+            "var_features": var_features, "con_features": con_features}
+
+
+def readArchive(archive_file):
+    """maps an archive of .cor instances written by corGenerator --output archive
+
+    Args:
+        archive_file: file path of the .cora archive
+
+    Returns:
+        a dict with the memory-mapped archive (data), its index (entries, an array with the fields
+        index, seed, hash, offset and length), the batch params and the number of instances of the batch
+
+    """
+    data = np.memmap(archive_file, dtype="u1", mode="r")
+    assert data[:8].tobytes() == b"corarch1" and data[-8:].tobytes() == b"coraidx1", \
+        "{} is not an archive".format(archive_file)
+    index_offset, count, instances, master_seed, shard, shards, params_length = \
+        map(int, data[-64:-8].view("<u8"))
+    entry = np.dtype([("index", "<u8"), ("seed", "<u8"), ("hash", "<u8"), ("offset", "<u8"), ("length", "<u8")])
+    entries = data[index_offset:index_offset+40*count].view(entry)
+    params_offset = index_offset + 40*count
+    params = data[params_offset:params_offset+params_length].tobytes().decode()
+    return {"data": data, "entries": entries, "params": params, "instances": instances,
+            "master_seed": master_seed, "shard": shard, "shards": shards}
+
+
+def parseCorArchive(archive, index):
+    """parses instance index of an archive returned by readArchive, as parseCor does"""
+    entries = archive["entries"]
+    # the entries are consecutive instances, so the position is found without a search
+    k = index - int(entries["index"][0]) if len(entries) else -1
+    if k < 0 or k >= len(entries) or int(entries["index"][k]) != index:
+        k = int(np.searchsorted(entries["index"], index))
+        assert k < len(entries) and int(entries["index"][k]) == index, "instance {} is not in the archive".format(index)
+    offset, length = int(entries["offset"][k]), int(entries["length"][k])
+    text = archive["data"][offset:offset+length].tobytes().decode()
+    return parseCorLines(text.splitlines())
+
 
 def generateMIPInstance(graph_data, budget=None, budget_frac=None):
     """creates a gurobi MIP instance from a corlat file
@@ -145,7 +247,13 @@ if __name__ == '__main__':
     args = parser.parse_args()
 
     # parse corlat instance
-    graph_data = parseCor(args.cor_file)
+    if args.cor_file.endswith(".cora"):
+        assert args.index is not None, "--index is required for an archive"
+        graph_data = parseCorArchive(readArchive(args.cor_file), args.index)
+    else:
+        graph_data = parseCor(args.cor_file)
+    if args.attr_file is not None:
+        graph_data = parseCorAttributes(graph_data, args.attr_file)
     
     # create MIP instance from corlat data and budget fraction
     model = generateMIPInstance(graph_data, budget_frac=args.budget_frac)
@@ -0,0 +1,318 @@
+// Functions to keep parsed graph files in a cache directory, so that runs
+// on the same graph file map its CSR arrays instead of parsing it again
+//
+// A snapshot is named after what it was parsed from: the FNV-1a 64-bit
+// hash and size of the graph file, its format and the bytes of an ARC
+// (graphutil.h), as HASH-SIZE-FORMAT-ARCBYTES.graph.  It holds, in the
+// byte order of the machine that wrote it,
+//
+//   header: magic "corgrph1", byte order mark, ARC bytes, hash, size,
+//           format, vertices n, arcs, asymmetric neighbors (64 bytes)
+//   start[0] ... start[n]   (ARCs)
+//   adj[0] ... adj[arcs-1]  (ints)
+//
+// so it is used by mapping it into memory, without reading it.  Hashing a
+// large graph file still takes a while, so the hash of each file is also
+// kept in src-DEV-INODE.link together with the size and modification time
+// of the file; while they do not change, the file is not read at all.  A
+// file that is changed gets a new hash, and thus a new snapshot; an
+// identical copy of a file finds the snapshot of the original.
+//
+// Snapshots and links are written to a temporary file (made with mkstemp)
+// that is then renamed, so runs sharing a cache never see a partial one.
+//
+// Function calls:
+//   int graph_cache_key(const char *dir, const char *filename, int format,
+//                       GRAPH_CACHE_KEY *key)
+//     -- Fills in the key of the graph file "filename" read as "format" in
+//        the cache "dir", which is created if it does not exist.  Returns 0,
+//        or 1 if the file cannot be read.
+//   int graph_cache_load(GRAPH_CACHE_KEY *key, int *n, ARC **start,
+//                        int **adj, long long *asymmetric)
+//     -- Maps the snapshot of the key, if there is one, and points *start
+//        and *adj into it (copy on write; they must not be freed).  The
+//        mapping is kept until the program exits.  Returns 0, or 1 if
+//        there is no valid snapshot.
+//   int graph_cache_store(GRAPH_CACHE_KEY *key, int n, const ARC *start,
+//                         const int *adj, long long asymmetric)
+//     -- Writes the snapshot of the key.  Returns 0, or 1 if it cannot be
+//        written.
+//   void graph_cache_free(GRAPH_CACHE_KEY *key)
+//     -- Frees the memory held by the key.
+
+
+// Inclusions
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "graphcache.h"
+
+// Constants
+
+#define MAGIC     "corgrph1"
+#define BYTEORDER 0x01020304u
+#define BUFFER    (1 << 20)        // Bytes hashed at once
+
+// Types
+
+typedef struct {
+  char magic[8];
+  unsigned int byteorder;
+  unsigned int arcbytes;
+  unsigned long long hash;
+  long long size;
+  int format,unused;
+  long long n;
+  long long arcs;
+  long long asymmetric;
+} HEADER;
+
+
+// Function to write n bytes, retrying short writes
+
+static int write_all(int fd, const void *data, size_t n)
+{
+  const char *p=data;
+  ssize_t done;
+
+  while (n>0) {
+    done = write(fd,p,n);
+    if (done<0) {
+      if (errno==EINTR) continue;
+      return 1;
+    }
+    p += done;
+    n -= done;
+  }
+  return 0;
+}
+
+
+// Function to make the path of a file of the cache; the caller frees it
+
+static char *cache_path(GRAPH_CACHE_KEY *key, const char *name)
+{
+  char *path;
+
+  path = malloc(strlen(key->dir)+strlen(name)+2);
+  if (path!=NULL) sprintf(path,"%s/%s",key->dir,name);
+  return path;
+}
+
+
+// Function to write "length" bytes to the file "name" of the cache, by way
+// of a temporary file
+
+static int write_cache_file(GRAPH_CACHE_KEY *key, const char *name,
+                            const void *data, size_t length,
+                            const ARC *start, size_t startbytes,
+                            const int *adj, size_t adjbytes)
+{
+  char tmpname[128];
+  char *path,*tmppath;
+  int fd,result;
+
+  // mkstemp() gives every writer its own temporary file, be it another
+  // thread or a process that shares the cache from another host or PID
+  // namespace
+  snprintf(tmpname,sizeof(tmpname),"%s.tmp.XXXXXX",name);
+  path = cache_path(key,name);
+  tmppath = cache_path(key,tmpname);
+  if ((path==NULL)||(tmppath==NULL)) {
+    free(path);
+    free(tmppath);
+    return 1;
+  }
+  result = 1;
+  fd = mkstemp(tmppath);
+  if (fd>=0) {
+    result = (fchmod(fd,0644)!=0);
+    if (result==0) result = write_all(fd,data,length);
+    if ((result==0)&&(startbytes>0)) result = write_all(fd,start,startbytes);
+    if ((result==0)&&(adjbytes>0)) result = write_all(fd,adj,adjbytes);
+    if (close(fd)!=0) result = 1;
+    if (result==0) result = (rename(tmppath,path)!=0);
+    if (result!=0) unlink(tmppath);
+  }
+  free(path);
+  free(tmppath);
+  return result;
+}
+
+
+// Function to compute the FNV-1a 64-bit hash of a file
+
+static int hash_file(const char *filename, unsigned long long *hash)
+{
+  unsigned char *buf;
+  size_t n,k;
+  unsigned long long h=0xcbf29ce484222325ULL;
+  FILE *fp;
+
+  fp = fopen(filename,"rb");
+  if (fp==NULL) return 1;
+  buf = malloc(BUFFER);
+  if (buf==NULL) {
+    fclose(fp);
+    return 1;
+  }
+  while ((n=fread(buf,1,BUFFER,fp))>0) {
+    for (k=0; k<n; k++) {
+      h ^= buf[k];
+      h *= 0x100000001b3ULL;
+    }
+  }
+  free(buf);
+  fclose(fp);
+  *hash = h;
+  return 0;
+}
+
+
+int graph_cache_key(const char *dir, const char *filename, int format,
+                    GRAPH_CACHE_KEY *key)
+{
+  struct stat st;
+  char name[128],line[256];
+  char *path;
+  long long size,mtime,mtimensec;
+  unsigned long long hash;
+  FILE *fp;
+  int found=0;
+
+  if (stat(filename,&st)!=0) return 1;
+  key->dir = malloc(strlen(dir)+1);
+  if (key->dir==NULL) return 1;
+  strcpy(key->dir,dir);
+  key->size = st.st_size;
+  key->format = format;
+  key->dev = (long long)st.st_dev;
+  key->ino = (long long)st.st_ino;
+  key->mtime = (long long)st.st_mtim.tv_sec;
+  key->mtimensec = (long long)st.st_mtim.tv_nsec;
+  mkdir(dir,0777);
+
+  // The hash recorded for this file, if the file is unchanged
+  snprintf(name,sizeof(name),"src-%lld-%lld.link",key->dev,key->ino);
+  path = cache_path(key,name);
+  if (path==NULL) return 1;
+  fp = fopen(path,"r");
+  free(path);
+  if (fp!=NULL) {
+    if ((fgets(line,sizeof(line),fp)!=NULL)&&
+        (sscanf(line,"%lld %lld %lld %llx",&size,&mtime,&mtimensec,&hash)==4)&&
+        (size==key->size)&&(mtime==key->mtime)&&(mtimensec==key->mtimensec)) {
+      key->hash = hash;
+      found = 1;
+    }
+    fclose(fp);
+  }
+  if (found) return 0;
+
+  if (hash_file(filename,&key->hash)!=0) return 1;
+  snprintf(line,sizeof(line),"%lld %lld %lld %016llx\n",key->size,
+           key->mtime,key->mtimensec,key->hash);
+  write_cache_file(key,name,line,strlen(line),NULL,0,NULL,0);
+  return 0;
+}
+
+
+// Function to make the name of the snapshot of a key
+
+static void snapshot_name(GRAPH_CACHE_KEY *key, char *name, size_t size)
+{
+  snprintf(name,size,"%016llx-%lld-%d-%d.graph",key->hash,key->size,
+           key->format,(int)sizeof(ARC));
+}
+
+
+int graph_cache_load(GRAPH_CACHE_KEY *key, int *n, ARC **start, int **adj,
+                     long long *asymmetric)
+{
+  char name[128];
+  char *path;
+  struct stat st;
+  HEADER h;
+  unsigned long long expected;
+  void *map;
+  ARC *s;
+  int fd;
+
+  snapshot_name(key,name,sizeof(name));
+  path = cache_path(key,name);
+  if (path==NULL) return 1;
+  fd = open(path,O_RDONLY);
+  free(path);
+  if (fd<0) return 1;
+  if ((fstat(fd,&st)!=0)||(st.st_size<GRAPH_CACHE_HEADER)||
+      (pread(fd,&h,sizeof(h),0)!=(ssize_t)sizeof(h))) {
+    close(fd);
+    return 1;
+  }
+
+  // The header must match the key and the size of the snapshot
+  if ((memcmp(h.magic,MAGIC,8)!=0)||(h.byteorder!=BYTEORDER)||
+      (h.arcbytes!=sizeof(ARC))||(h.hash!=key->hash)||(h.size!=key->size)||
+      (h.format!=key->format)||(h.n<0)||(h.n>INT_MAX)||(h.arcs<0)||
+      (h.arcs>ARC_MAX)) {
+    close(fd);
+    return 1;
+  }
+  expected = GRAPH_CACHE_HEADER + (unsigned long long)(h.n+1)*sizeof(ARC)
+             + (unsigned long long)h.arcs*sizeof(int);
+  if ((unsigned long long)st.st_size!=expected) {
+    close(fd);
+    return 1;
+  }
+  map = mmap(NULL,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+  close(fd);
+  if (map==MAP_FAILED) return 1;
+
+  s = (ARC *)((char *)map + GRAPH_CACHE_HEADER);
+  if ((s[0]!=0)||(s[h.n]!=h.arcs)) {
+    munmap(map,st.st_size);
+    return 1;
+  }
+  *n = (int)h.n;
+  *start = s;
+  *adj = (int *)(s + h.n + 1);
+  *asymmetric = h.asymmetric;
+  return 0;
+}
+
+
+int graph_cache_store(GRAPH_CACHE_KEY *key, int n, const ARC *start,
+                      const int *adj, long long asymmetric)
+{
+  char name[128];
+  HEADER h;
+
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,MAGIC,8);
+  h.byteorder = BYTEORDER;
+  h.arcbytes = sizeof(ARC);
+  h.hash = key->hash;
+  h.size = key->size;
+  h.format = key->format;
+  h.n = n;
+  h.arcs = start[n];
+  h.asymmetric = asymmetric;
+  snapshot_name(key,name,sizeof(name));
+  return write_cache_file(key,name,&h,sizeof(h),start,
+                          sizeof(ARC)*((size_t)n+1),adj,
+                          sizeof(int)*(size_t)start[n]);
+}
+
+
+void graph_cache_free(GRAPH_CACHE_KEY *key)
+{
+  free(key->dir);
+  key->dir = NULL;
+}
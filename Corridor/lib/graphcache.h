@@ -0,0 +1,27 @@
+// Header file for the cache of parsed graph files
+
+#ifndef _GRAPHCACHE_H
+#define _GRAPHCACHE_H
+
+#include "graphutil.h"
+
+#define GRAPH_CACHE_HEADER 64      // Bytes before the start[] array
+
+typedef struct {
+  char *dir;                       // Directory of the cache
+  unsigned long long hash;         // FNV-1a 64-bit hash of the graph file
+  long long size;                  // Bytes of the graph file
+  int format;                      // GRAPH_* of readgraph.h
+  long long dev,ino;               // Identity of the graph file
+  long long mtime,mtimensec;
+} GRAPH_CACHE_KEY;
+
+int graph_cache_key(const char *dir, const char *filename, int format,
+                    GRAPH_CACHE_KEY *key);
+int graph_cache_load(GRAPH_CACHE_KEY *key, int *n, ARC **start, int **adj,
+                     long long *asymmetric);
+int graph_cache_store(GRAPH_CACHE_KEY *key, int n, const ARC *start,
+                      const int *adj, long long asymmetric);
+void graph_cache_free(GRAPH_CACHE_KEY *key);
+
+#endif
@@ -0,0 +1,946 @@
+// Functions on graphs stored as CSR arrays (see graphutil.h)
+//
+// Function calls:
+//   int graph_order(int n, const ARC *start, const int *adj, int method,
+//                   const int *roots, int *order)
+//     -- Computes a new order of the vertices: order[k] is the vertex that
+//        comes k-th.  "method" is one of
+//          ORDER_RCM    -- reverse Cuthill-McKee, started in every connected
+//                          component from a pseudo-peripheral vertex
+//          ORDER_BFS    -- breadth-first order, started in every component
+//                          from its first vertex with roots[v] != 0 (if
+//                          roots is not NULL and there is one), otherwise
+//                          from its first vertex
+//          ORDER_DEGREE -- decreasing degree, ties broken by vertex number
+//        Returns 0 if successful.
+//   int graph_permute(int n, const ARC *start, const int *adj,
+//                     const int *order, ARC *newstart, int *newadj)
+//     -- Renumbers the graph so that vertex order[k] becomes vertex k; the
+//        neighbor lists of the new graph are sorted.  newstart must have
+//        room for n+1 ARCs and newadj for start[n] ints.
+//   int graph_bandwidth(int n, const ARC *start, const int *adj)
+//     -- Returns the largest |i-j| over all edges (i,j).
+//   int graph_terminal_distances(int n, const ARC *start, const int *adj,
+//                                int nterm, const int *term, int *dist)
+//     -- Sets the distances between all pairs term[a], term[b] with a<b,
+//        in the order (0,1), (0,2) ... (0,nterm-1), (1,2) ...: the number
+//        of edges on a shortest path, or -1 if there is none.  dist must
+//        have room for nterm*(nterm-1)/2 ints.
+//        One breadth-first search per terminal, stopped as soon as it has
+//        reached all the later terminals.  Returns 0 if successful.
+//   int graph_weighted_distances(int n, const ARC *start, const int *adj,
+//                                const int *weight, int source,
+//                                long long *dist)
+//     -- Sets dist[v] to the least total weight of the vertices on a path
+//        from "source" to v, both ends included, or -1 if there is none.
+//        Weights must not be negative (Dijkstra).  Returns 0 if successful.
+//   int graph_steiner_tree(int n, const ARC *start, const int *adj,
+//                          const int *weight, int nterm, const int *term,
+//                          int *parent, int *order, int *count)
+//     -- Connects the terminals by a tree of small total vertex weight with
+//        the shortest-path heuristic: the tree starts as term[0], and the
+//        terminal that is cheapest to reach from it is joined to it by a
+//        cheapest path, until all are joined.  One Dijkstra search from the
+//        tree runs throughout: the vertices of each new path become sources
+//        of distance 0, and only the distances they lower are updated.
+//        Sets parent[v] to the parent of v in the tree (-1 for term[0],
+//        -2 if v is not in the tree), and order[0] ... order[*count-1] to
+//        the vertices of the tree, each after its parent.  Weights must not
+//        be negative.  Returns 0 if successful, 2 if a terminal cannot be
+//        reached.
+//   int graph_greedy_grow(int n, const ARC *start, const int *adj,
+//                         const int *cost, const int *value, double budget,
+//                         long long *spent, int *parent, int *order,
+//                         int *count)
+//     -- Grows the tree of graph_steiner_tree() by adding, while the total
+//        cost *spent stays within budget, the neighbor of the tree with the
+//        largest value per cost (vertices of value <= 0 are never added).
+//        Updates *spent, parent, order and *count.  Returns 0 if successful.
+//   int graph_heavy_matching(int n, const ARC *start, const int *adj,
+//                            const int *weight, int *map)
+//     -- Matches the vertices in pairs along edges of large weight (heavy
+//        edge matching): in order of increasing degree, each unmatched
+//        vertex is paired with the unmatched neighbor joined to it by the
+//        heaviest edge, or left alone if there is none.  weight[k] is the
+//        weight of edge adj[k], or every edge weighs 1 if weight is NULL.
+//        Sets map[v] to the pair of v, the pairs numbered in the order of
+//        their smaller vertex, and returns the number of pairs, or -1 if
+//        out of memory.
+//   int graph_contract(int n, const ARC *start, const int *adj,
+//                      const int *weight, const int *map, int nc,
+//                      ARC *cstart, int *cadj, int *cweight)
+//     -- Builds the graph of nc vertices in which vertex map[v] stands for
+//        all the vertices v mapped to it: two are neighbors if any of their
+//        vertices are, and the edge weighs the sum of the weights of those
+//        edges (1 each if weight is NULL).  Loops are dropped and neighbor
+//        lists are sorted.  cstart must have room for nc+1 ARCs, and cadj
+//        and cweight (which may be NULL) for start[n] ints.  Returns 0 if
+//        successful.
+//   int graph_partition(int n, const ARC *start, const int *adj, int k,
+//                       int *part)
+//     -- Splits the vertices into k parts of nearly equal size with few
+//        edges between them, and sets part[v] to the part (0 ... k-1) of v.
+//        Multilevel: the graph is coarsened by graph_heavy_matching() and
+//        graph_contract(), the breadth-first order of the coarsest graph is
+//        cut into k pieces of equal weight, and the parts are projected
+//        back level by level, each time refined by size-constrained label
+//        propagation (a vertex moves to the part it has the most edges to,
+//        if that part stays within PARTITION_IMBALANCE of the average).
+//        Returns 0 if successful.
+
+
+// Inclusions
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "graphutil.h"
+
+// Constants
+
+#define PERIPHERAL_ITERATIONS 8
+#define PARTITION_LEVELS      64    // Most levels of coarsening
+#define PARTITION_COARSEST    8     // Coarsen down to this many vertices per part
+#define PARTITION_SHRINK      0.95  // Stop coarsening when it shrinks less
+#define PARTITION_IMBALANCE   0.03  // Parts may be this much above average
+#define PARTITION_ROUNDS      10    // Most label propagation sweeps per level
+
+// Globals
+
+static const ARC *degree_start;  // Used by the comparison functions
+
+
+int graph_order_from_name(const char *name)
+{
+  if (strcmp(name,"none")==0) return ORDER_NONE;
+  if (strcmp(name,"rcm")==0) return ORDER_RCM;
+  if (strcmp(name,"bfs")==0) return ORDER_BFS;
+  if (strcmp(name,"degree")==0) return ORDER_DEGREE;
+  return -1;
+}
+
+
+// Functions to compare vertices by increasing and decreasing degree
+
+static int cmp_increasing_degree(const void *a, const void *b)
+{
+  int u = *(const int *)a;
+  int v = *(const int *)b;
+  ARC du = degree_start[u+1] - degree_start[u];
+  ARC dv = degree_start[v+1] - degree_start[v];
+
+  if (du!=dv) return (du>dv) - (du<dv);
+  return (u>v) - (u<v);
+}
+
+static int cmp_decreasing_degree(const void *a, const void *b)
+{
+  int u = *(const int *)a;
+  int v = *(const int *)b;
+  ARC du = degree_start[u+1] - degree_start[u];
+  ARC dv = degree_start[v+1] - degree_start[v];
+
+  if (du!=dv) return (du<dv) - (du>dv);
+  return (u>v) - (u<v);
+}
+
+static int cmp_int(const void *a, const void *b)
+{
+  int x = *(const int *)a;
+  int y = *(const int *)b;
+  return (x>y) - (x<y);
+}
+
+
+// Function to do a breadth-first search from "root" over the vertices not
+// yet placed; vertices reached are marked with "stamp".  Returns the depth
+// of the search, leaves the vertices reached in queue[0] ... queue[*size-1]
+// and sets "last" to a vertex of least degree in the deepest level.
+
+static int bfs_depth(const ARC *start, const int *adj, int root,
+                     const int *placed, int *mark, int stamp, int *queue,
+                     int *level, int *last, int *size)
+{
+  int head,tail,u,v,depth;
+  ARC k;
+
+  head = tail = 0;
+  queue[tail++] = root;
+  mark[root] = stamp;
+  level[root] = 0;
+  depth = 0;
+  *last = root;
+  while (head<tail) {
+    u = queue[head++];
+    if (level[u]>depth) {
+      depth = level[u];
+      *last = u;
+    } else if ((level[u]==depth)&&
+	       (start[u+1]-start[u]<start[*last+1]-start[*last])) *last = u;
+    for (k=start[u]; k<start[u+1]; k++) {
+      v = adj[k];
+      if (placed[v]||(mark[v]==stamp)) continue;
+      mark[v] = stamp;
+      level[v] = level[u] + 1;
+      queue[tail++] = v;
+    }
+  }
+  *size = tail;
+  return depth;
+}
+
+
+// Function to find a pseudo-peripheral vertex of the component of "root"
+// (George and Liu)
+
+static int peripheral_vertex(const ARC *start, const int *adj, int root,
+                             const int *placed, int *mark, int *stamp,
+                             int *queue, int *level)
+{
+  int i,v,u,w,depth,newdepth,size;
+
+  v = root;
+  depth = bfs_depth(start,adj,v,placed,mark,++(*stamp),queue,level,&u,&size);
+  for (i=0; i<PERIPHERAL_ITERATIONS; i++) {
+    newdepth = bfs_depth(start,adj,u,placed,mark,++(*stamp),queue,level,&w,
+			 &size);
+    if (newdepth<=depth) break;
+    v = u;
+    depth = newdepth;
+    u = w;
+  }
+  return v;
+}
+
+
+// Function to append the component of "root" to order[] in breadth-first
+// order; with "bydegree" the neighbors of each vertex are taken in order of
+// increasing degree (Cuthill-McKee).  Returns the new length of order[].
+
+static int bfs_append(const ARC *start, const int *adj, int root,
+                      int bydegree, int *placed, int *order, int count,
+                      int *buffer)
+{
+  int head,u,v,nbuf;
+  ARC k;
+
+  head = count;
+  order[count++] = root;
+  placed[root] = 1;
+  while (head<count) {
+    u = order[head++];
+    nbuf = 0;
+    for (k=start[u]; k<start[u+1]; k++) {
+      v = adj[k];
+      if (placed[v]) continue;
+      placed[v] = 1;
+      buffer[nbuf++] = v;
+    }
+    if (bydegree&&(nbuf>1))
+      qsort(buffer,nbuf,sizeof(int),cmp_increasing_degree);
+    memcpy(order+count,buffer,nbuf*sizeof(int));
+    count += nbuf;
+  }
+  return count;
+}
+
+
+int graph_order(int n, const ARC *start, const int *adj, int method,
+                const int *roots, int *order)
+{
+  int i,k,v,count,stamp,size;
+  int *placed,*mark,*queue,*level,*buffer;
+
+  degree_start = start;
+
+  if ((method==ORDER_NONE)||(method==ORDER_DEGREE)) {
+    for (i=0; i<n; i++) order[i] = i;
+    if (method==ORDER_DEGREE)
+      qsort(order,n,sizeof(int),cmp_decreasing_degree);
+    return 0;
+  }
+  if ((method!=ORDER_RCM)&&(method!=ORDER_BFS)) return 1;
+
+  placed = calloc(n+1,sizeof(int));
+  mark = calloc(n+1,sizeof(int));
+  queue = malloc((n+1)*sizeof(int));
+  level = malloc((n+1)*sizeof(int));
+  buffer = malloc((n+1)*sizeof(int));
+  stamp = 0;
+  count = 0;
+
+  for (i=0; i<n; i++) {
+    if (placed[i]) continue;
+    if (method==ORDER_RCM) {
+      v = peripheral_vertex(start,adj,i,placed,mark,&stamp,queue,level);
+    } else {
+      v = i;
+      if (roots!=NULL) {
+	// The component of i is what a search from i reaches; start from
+	// its first root
+	bfs_depth(start,adj,i,placed,mark,++stamp,queue,level,&k,&size);
+	v = -1;
+	for (k=0; k<size; k++) {
+	  if (roots[queue[k]]&&((v<0)||(queue[k]<v))) v = queue[k];
+	}
+	if (v<0) v = i;
+      }
+    }
+    count = bfs_append(start,adj,v,method==ORDER_RCM,placed,order,count,
+		       buffer);
+  }
+
+  if (method==ORDER_RCM) {
+    for (i=0; i<n/2; i++) {
+      v = order[i];
+      order[i] = order[n-1-i];
+      order[n-1-i] = v;
+    }
+  }
+
+  free(placed);
+  free(mark);
+  free(queue);
+  free(level);
+  free(buffer);
+  return 0;
+}
+
+
+int graph_permute(int n, const ARC *start, const int *adj, const int *order,
+                  ARC *newstart, int *newadj)
+{
+  int i,u;
+  ARC k,pos;
+  int *inverse;
+
+  inverse = malloc((n+1)*sizeof(int));
+  for (i=0; i<n; i++) inverse[order[i]] = i;
+
+  pos = 0;
+  for (i=0; i<n; i++) {
+    u = order[i];
+    newstart[i] = pos;
+    for (k=start[u]; k<start[u+1]; k++) newadj[pos++] = inverse[adj[k]];
+    qsort(newadj+newstart[i],pos-newstart[i],sizeof(int),cmp_int);
+  }
+  newstart[n] = pos;
+
+  free(inverse);
+  return 0;
+}
+
+
+int graph_bandwidth(int n, const ARC *start, const int *adj)
+{
+  int i,d,width=0;
+  ARC k;
+
+  for (i=0; i<n; i++) {
+    for (k=start[i]; k<start[i+1]; k++) {
+      d = (adj[k]>i) ? adj[k]-i : i-adj[k];
+      if (d>width) width = d;
+    }
+  }
+  return width;
+}
+
+
+int graph_terminal_distances(int n, const ARC *start, const int *adj,
+                             int nterm, const int *term, int *dist)
+{
+  int a,b,u,v,head,tail,found;
+  ARC k;
+  long long row,pairs;
+  int *index,*level,*queue;
+
+  index = malloc((n>0?n:1)*sizeof(int));
+  level = malloc((n>0?n:1)*sizeof(int));
+  queue = malloc((n>0?n:1)*sizeof(int));
+  if ((index==NULL)||(level==NULL)||(queue==NULL)) {
+    free(index);
+    free(level);
+    free(queue);
+    return 1;
+  }
+
+  for (u=0; u<n; u++) index[u] = -1;
+  for (a=0; a<nterm; a++) index[term[a]] = a;
+  pairs = (long long)nterm*(nterm-1)/2;
+  for (row=0; row<pairs; row++) dist[row] = -1;
+
+  for (u=0; u<n; u++) level[u] = -1;
+  row = 0;                              // Position of the pair (a,a+1)
+  for (a=0; a<nterm-1; a++) {
+
+    // Search from term[a] until all the later terminals have been reached
+    found = 0;
+    head = tail = 0;
+    queue[tail++] = term[a];
+    level[term[a]] = 0;
+    while ((head<tail)&&(found<nterm-1-a)) {
+      u = queue[head++];
+      for (k=start[u]; k<start[u+1]; k++) {
+	v = adj[k];
+	if (level[v]>=0) continue;
+	level[v] = level[u] + 1;
+	queue[tail++] = v;
+	b = index[v];
+	if (b>a) {
+	  dist[row+b-a-1] = level[v];
+	  found++;
+	}
+      }
+    }
+    for (k=0; k<tail; k++) level[queue[k]] = -1;
+    row += nterm - 1 - a;
+  }
+
+  free(index);
+  free(level);
+  free(queue);
+  return 0;
+}
+
+
+// Functions to maintain a binary min-heap of (distance,vertex) pairs
+
+typedef struct {
+  long long key;
+  int vertex;
+} HEAPITEM;
+
+static void heap_push(HEAPITEM *heap, ARC *size, long long key, int vertex)
+{
+  ARC i,p;
+
+  i = (*size)++;
+  while (i>0) {
+    p = (i-1)/2;
+    if (heap[p].key<=key) break;
+    heap[i] = heap[p];
+    i = p;
+  }
+  heap[i].key = key;
+  heap[i].vertex = vertex;
+}
+
+static HEAPITEM heap_pop(HEAPITEM *heap, ARC *size)
+{
+  HEAPITEM top,last;
+  ARC i,c;
+
+  top = heap[0];
+  last = heap[--(*size)];
+  i = 0;
+  while ((c=2*i+1)<*size) {
+    if ((c+1<*size)&&(heap[c+1].key<heap[c].key)) c++;
+    if (last.key<=heap[c].key) break;
+    heap[i] = heap[c];
+    i = c;
+  }
+  heap[i] = last;
+  return top;
+}
+
+
+int graph_weighted_distances(int n, const ARC *start, const int *adj,
+                             const int *weight, int source, long long *dist)
+{
+  int u,v;
+  ARC k,size;
+  long long d;
+  HEAPITEM *heap;
+  HEAPITEM item;
+
+  // Every edge is pushed at most once, plus the source
+  heap = malloc(((size_t)start[n]+1)*sizeof(HEAPITEM));
+  if (heap==NULL) return 1;
+
+  for (u=0; u<n; u++) dist[u] = -1;
+  size = 0;
+  dist[source] = weight[source];
+  heap_push(heap,&size,dist[source],source);
+  while (size>0) {
+    item = heap_pop(heap,&size);
+    u = item.vertex;
+    if (item.key>dist[u]) continue;
+    for (k=start[u]; k<start[u+1]; k++) {
+      v = adj[k];
+      d = item.key + weight[v];
+      if ((dist[v]<0)||(d<dist[v])) {
+	dist[v] = d;
+	heap_push(heap,&size,d,v);
+      }
+    }
+  }
+
+  free(heap);
+  return 0;
+}
+
+
+int graph_steiner_tree(int n, const ARC *start, const int *adj,
+                       const int *weight, int nterm, const int *term,
+                       int *parent, int *order, int *count)
+{
+  int u,v,joined,t;
+  ARC k,size;
+  long long d;
+  long long *dist;
+  int *pred,*isterm;
+  HEAPITEM *heap;
+  HEAPITEM item;
+
+  dist = malloc(n*sizeof(long long));
+  pred = malloc(n*sizeof(int));
+  isterm = calloc(n,sizeof(int));
+  // A vertex is pushed when its distance falls, at most once per edge into
+  // it and once as a source
+  heap = malloc(((size_t)start[n]+n+1)*sizeof(HEAPITEM));
+  if ((dist==NULL)||(pred==NULL)||(isterm==NULL)||(heap==NULL)) {
+    free(dist);
+    free(pred);
+    free(isterm);
+    free(heap);
+    return 1;
+  }
+
+  for (u=0; u<n; u++) {
+    parent[u] = -2;
+    dist[u] = -1;
+  }
+  for (k=0; k<nterm; k++) isterm[term[k]] = 1;
+  *count = 0;
+  size = 0;
+  if (nterm>0) {
+    parent[term[0]] = -1;
+    order[(*count)++] = term[0];
+    dist[term[0]] = 0;
+    heap_push(heap,&size,0,term[0]);
+  }
+
+  for (joined=1; joined<nterm; ) {
+    // Continue the search up to the first terminal outside the tree
+    t = -1;
+    while (size>0) {
+      item = heap_pop(heap,&size);
+      u = item.vertex;
+      if (item.key>dist[u]) continue;
+      if (isterm[u]&&(parent[u]==-2)) {
+        t = u;
+        break;
+      }
+      for (k=start[u]; k<start[u+1]; k++) {
+        v = adj[k];
+        d = item.key + weight[v];
+        if ((dist[v]<0)||(d<dist[v])) {
+          dist[v] = d;
+          pred[v] = u;
+          heap_push(heap,&size,d,v);
+        }
+      }
+    }
+    if (t<0) break;
+
+    // Add the path from the tree to t, nearest vertex first (in the unused
+    // end of order); it may pass through other terminals
+    for (v=t,k=n; parent[v]==-2; v=pred[v]) order[--k] = v;
+    while (k<n) {
+      v = order[k++];
+      parent[v] = pred[v];
+      order[(*count)++] = v;
+      if (isterm[v]) joined++;
+      dist[v] = 0;
+      heap_push(heap,&size,0,v);
+    }
+  }
+
+  free(dist);
+  free(pred);
+  free(isterm);
+  free(heap);
+  return (joined<nterm) ? 2 : 0;
+}
+
+
+// Functions to maintain a binary max-heap of (value per cost,vertex) pairs
+
+typedef struct {
+  double key;
+  int vertex,from;
+} RATIOITEM;
+
+static void ratio_push(RATIOITEM *heap, ARC *size, double key, int vertex,
+                       int from)
+{
+  ARC i,p;
+
+  i = (*size)++;
+  while (i>0) {
+    p = (i-1)/2;
+    if (heap[p].key>=key) break;
+    heap[i] = heap[p];
+    i = p;
+  }
+  heap[i].key = key;
+  heap[i].vertex = vertex;
+  heap[i].from = from;
+}
+
+static RATIOITEM ratio_pop(RATIOITEM *heap, ARC *size)
+{
+  RATIOITEM top,last;
+  ARC i,c;
+
+  top = heap[0];
+  last = heap[--(*size)];
+  i = 0;
+  while ((c=2*i+1)<*size) {
+    if ((c+1<*size)&&(heap[c+1].key>heap[c].key)) c++;
+    if (last.key>=heap[c].key) break;
+    heap[i] = heap[c];
+    i = c;
+  }
+  heap[i] = last;
+  return top;
+}
+
+static void push_neighbors(const ARC *start, const int *adj, const int *cost,
+                           const int *value, const int *parent, int u,
+                           RATIOITEM *heap, ARC *size)
+{
+  int v;
+  ARC k;
+
+  for (k=start[u]; k<start[u+1]; k++) {
+    v = adj[k];
+    if ((parent[v]!=-2)||(value[v]<=0)) continue;
+    ratio_push(heap,size,(cost[v]>0) ? (double)value[v]/cost[v] : 1e300,v,u);
+  }
+}
+
+
+int graph_greedy_grow(int n, const ARC *start, const int *adj,
+                      const int *cost, const int *value, double budget,
+                      long long *spent, int *parent, int *order, int *count)
+{
+  int k,u;
+  ARC size;
+  char *rejected;
+  RATIOITEM *heap;
+  RATIOITEM item;
+
+  rejected = calloc(n,1);
+  // Every edge is pushed at most once
+  heap = malloc(((size_t)start[n]+1)*sizeof(RATIOITEM));
+  if ((rejected==NULL)||(heap==NULL)) {
+    free(rejected);
+    free(heap);
+    return 1;
+  }
+
+  size = 0;
+  for (k=0; k<*count; k++)
+    push_neighbors(start,adj,cost,value,parent,order[k],heap,&size);
+  while (size>0) {
+    item = ratio_pop(heap,&size);
+    u = item.vertex;
+    if ((parent[u]!=-2)||rejected[u]) continue;
+    // The budget only shrinks, so a vertex that does not fit never will
+    if ((double)(*spent+cost[u])>budget) {
+      rejected[u] = 1;
+      continue;
+    }
+    *spent += cost[u];
+    parent[u] = item.from;
+    order[(*count)++] = u;
+    push_neighbors(start,adj,cost,value,parent,u,heap,&size);
+  }
+
+  free(rejected);
+  free(heap);
+  return 0;
+}
+
+
+int graph_heavy_matching(int n, const ARC *start, const int *adj,
+                         const int *weight, int *map)
+{
+  int i,u,v,best,bestweight,w,nc;
+  ARC k;
+  int *visit,*mate;
+
+  visit = malloc((n>0 ? n : 1)*sizeof(int));
+  mate = malloc((n>0 ? n : 1)*sizeof(int));
+  if ((visit==NULL)||(mate==NULL)) {
+    free(visit);
+    free(mate);
+    return -1;
+  }
+
+  // Vertices of low degree are matched first, as they have fewer choices
+  for (i=0; i<n; i++) {
+    visit[i] = i;
+    mate[i] = -1;
+  }
+  degree_start = start;
+  qsort(visit,n,sizeof(int),cmp_increasing_degree);
+
+  for (i=0; i<n; i++) {
+    u = visit[i];
+    if (mate[u]>=0) continue;
+    best = u;
+    bestweight = 0;
+    for (k=start[u]; k<start[u+1]; k++) {
+      v = adj[k];
+      if ((v==u)||(mate[v]>=0)) continue;
+      w = (weight==NULL) ? 1 : weight[k];
+      if (w>bestweight) {
+        best = v;
+        bestweight = w;
+      }
+    }
+    mate[u] = best;
+    mate[best] = u;
+  }
+
+  // Number the pairs in the order of their smaller vertex
+  nc = 0;
+  for (u=0; u<n; u++) {
+    if (mate[u]>=u) map[u] = nc++;
+    else map[u] = map[mate[u]];
+  }
+
+  free(visit);
+  free(mate);
+  return nc;
+}
+
+
+int graph_contract(int n, const ARC *start, const int *adj,
+                   const int *weight, const int *map, int nc,
+                   ARC *cstart, int *cadj, int *cweight)
+{
+  int c,i,u,v,cv;
+  ARC k,m,first;
+  int *member,*mstart,*mark,*acc;
+
+  member = malloc((n>0 ? n : 1)*sizeof(int));
+  mstart = calloc(nc+1,sizeof(int));
+  mark = malloc((nc>0 ? nc : 1)*sizeof(int));
+  acc = calloc(nc>0 ? nc : 1,sizeof(int));
+  if ((member==NULL)||(mstart==NULL)||(mark==NULL)||(acc==NULL)) {
+    free(member);
+    free(mstart);
+    free(mark);
+    free(acc);
+    return 1;
+  }
+
+  // Bucket the vertices by coarse vertex
+  for (u=0; u<n; u++) mstart[map[u]+1]++;
+  for (c=0; c<nc; c++) mstart[c+1] += mstart[c];
+  for (u=0; u<n; u++) member[mstart[map[u]]++] = u;
+  for (c=nc; c>0; c--) mstart[c] = mstart[c-1];
+  mstart[0] = 0;
+
+  for (c=0; c<nc; c++) mark[c] = -1;
+  m = 0;
+  for (c=0; c<nc; c++) {
+    cstart[c] = first = m;
+    for (i=mstart[c]; i<mstart[c+1]; i++) {
+      u = member[i];
+      for (k=start[u]; k<start[u+1]; k++) {
+        cv = map[adj[k]];
+        if (cv==c) continue;
+        if (mark[cv]!=c) {
+          mark[cv] = c;
+          cadj[m++] = cv;
+        }
+        acc[cv] += (weight==NULL) ? 1 : weight[k];
+      }
+    }
+    qsort(cadj+first,m-first,sizeof(int),cmp_int);
+    for (k=first; k<m; k++) {
+      v = cadj[k];
+      if (cweight!=NULL) cweight[k] = acc[v];
+      acc[v] = 0;
+    }
+  }
+  cstart[nc] = m;
+
+  free(member);
+  free(mstart);
+  free(mark);
+  free(acc);
+  return 0;
+}
+
+
+// Functions for graph_partition()
+
+typedef struct {
+  int n;
+  ARC *start;
+  int *adj;
+  int *weight;           // Edge weights (NULL for the input graph)
+  int *vweight;          // Vertex weights
+  int *map;              // Vertex of the next coarser level
+} LEVEL;
+
+// Function to move vertices to the part they are most strongly joined to,
+// as long as that part stays within maxweight (size-constrained label
+// propagation).  A vertex also moves, at equal connection, to a lighter
+// part, and leaves an overweight part for any neighboring part with room.
+// Stops after "rounds" sweeps or when nothing moves.  conn must
+// have room for k long longs, all 0, and touched for k ints.
+
+static void refine_parts(const LEVEL *g, long long maxweight,
+                         int rounds, int *part, long long *pweight,
+                         long long *conn, int *touched)
+{
+  int r,u,p,q,i,best,ntouched,moved;
+  long long w;
+  ARC e;
+
+  for (r=0; r<rounds; r++) {
+    moved = 0;
+    for (u=0; u<g->n; u++) {
+      p = part[u];
+      w = g->vweight[u];
+      ntouched = 0;
+      for (e=g->start[u]; e<g->start[u+1]; e++) {
+	q = part[g->adj[e]];
+	if (conn[q]==0) touched[ntouched++] = q;
+	conn[q] += (g->weight==NULL) ? 1 : g->weight[e];
+      }
+      // A vertex of an overweight part moves to the best part with room
+      best = (pweight[p]>maxweight) ? -1 : p;
+      for (i=0; i<ntouched; i++) {
+	q = touched[i];
+	if ((q==p)||(pweight[q]+w>maxweight)) continue;
+	if ((best<0)||(conn[q]>conn[best])||
+	    ((conn[q]==conn[best])&&(pweight[q]+w<pweight[best]))) best = q;
+      }
+      if (best<0) best = p;
+      for (i=0; i<ntouched; i++) conn[touched[i]] = 0;
+      if (best!=p) {
+	pweight[p] -= w;
+	pweight[best] += w;
+	part[u] = best;
+	moved++;
+      }
+    }
+    if (moved==0) break;
+  }
+}
+
+
+int graph_partition(int n, const ARC *start, const int *adj, int k,
+                    int *part)
+{
+  LEVEL level[PARTITION_LEVELS];
+  int nlevels,l,i,u,p,nc,result=1;
+  int *order=NULL,*touched=NULL,*coarse,*fine;
+  long long total,acc,maxweight;
+  long long *pweight=NULL,*conn=NULL;
+  LEVEL *g,*c;
+
+  if (k<1) return 1;
+  level[0].n = n;
+  level[0].start = (ARC *)start;
+  level[0].adj = (int *)adj;
+  level[0].weight = NULL;
+  level[0].vweight = malloc((n>0 ? n : 1)*sizeof(int));
+  level[0].map = NULL;
+  if (level[0].vweight==NULL) return 1;
+  for (u=0; u<n; u++) level[0].vweight[u] = 1;
+  nlevels = 1;
+
+  // Coarsen by heavy edge matching while it still shrinks the graph
+  while ((nlevels<PARTITION_LEVELS)&&
+	 (level[nlevels-1].n>PARTITION_COARSEST*(long long)k)) {
+    g = &level[nlevels-1];
+    c = &level[nlevels];
+    g->map = malloc((g->n>0 ? g->n : 1)*sizeof(int));
+    if (g->map==NULL) goto done;
+    nc = graph_heavy_matching(g->n,g->start,g->adj,g->weight,g->map);
+    if ((nc<0)||(nc>PARTITION_SHRINK*g->n)) {
+      free(g->map);
+      g->map = NULL;
+      if (nc<0) goto done;
+      break;
+    }
+    c->n = nc;
+    c->start = malloc((nc+1)*sizeof(ARC));
+    c->adj = malloc(((size_t)g->start[g->n]+1)*sizeof(int));
+    c->weight = malloc(((size_t)g->start[g->n]+1)*sizeof(int));
+    c->vweight = calloc(nc>0 ? nc : 1,sizeof(int));
+    c->map = NULL;
+    nlevels++;
+    if ((c->start==NULL)||(c->adj==NULL)||(c->weight==NULL)||
+	(c->vweight==NULL)) goto done;
+    if (graph_contract(g->n,g->start,g->adj,g->weight,g->map,nc,c->start,
+		       c->adj,c->weight)!=0) goto done;
+    for (u=0; u<g->n; u++) c->vweight[g->map[u]] += g->vweight[u];
+  }
+
+  // Cut the breadth-first order of the coarsest graph into k pieces of
+  // equal weight
+  g = &level[nlevels-1];
+  coarse = (nlevels>1) ? malloc((g->n>0 ? g->n : 1)*sizeof(int)) : part;
+  order = malloc((g->n>0 ? g->n : 1)*sizeof(int));
+  touched = malloc(k*sizeof(int));
+  pweight = calloc(k,sizeof(long long));
+  conn = calloc(k,sizeof(long long));
+  if ((coarse==NULL)||(order==NULL)||(touched==NULL)||(pweight==NULL)||
+      (conn==NULL)) {
+    if (coarse!=part) free(coarse);
+    goto done;
+  }
+  graph_order(g->n,g->start,g->adj,ORDER_BFS,NULL,order);
+  total = n;
+  maxweight = (long long)((1.0+PARTITION_IMBALANCE)*total/k) + 1;
+  acc = 0;
+  for (i=0; i<g->n; i++) {
+    u = order[i];
+    p = (total>0) ? (int)((acc+g->vweight[u]/2)*k/total) : 0;
+    if (p>=k) p = k - 1;
+    coarse[u] = p;
+    pweight[p] += g->vweight[u];
+    acc += g->vweight[u];
+  }
+  refine_parts(g,maxweight,PARTITION_ROUNDS,coarse,pweight,conn,touched);
+
+  // Project the parts back level by level, refining each
+  for (l=nlevels-2; l>=0; l--) {
+    g = &level[l];
+    fine = (l>0) ? malloc((g->n>0 ? g->n : 1)*sizeof(int)) : part;
+    if (fine==NULL) {
+      free(coarse);
+      goto done;
+    }
+    for (u=0; u<g->n; u++) fine[u] = coarse[g->map[u]];
+    free(coarse);
+    coarse = fine;
+    refine_parts(g,maxweight,PARTITION_ROUNDS,coarse,pweight,conn,touched);
+  }
+  result = 0;
+
+ done:
+  free(order);
+  free(touched);
+  free(pweight);
+  free(conn);
+  for (l=0; l<nlevels; l++) {
+    if (l>0) {
+      free(level[l].start);
+      free(level[l].adj);
+      free(level[l].weight);
+    }
+    free(level[l].vweight);
+    free(level[l].map);
+  }
+  return result;
+}
@@ -0,0 +1,52 @@
+// Header file for functions on graphs stored as CSR arrays: the neighbors
+// of vertex i are adj[start[i]] ... adj[start[i+1]-1]
+
+#ifndef _GRAPHUTIL_H
+#define _GRAPHUTIL_H
+
+#include <limits.h>
+
+// Positions in adj (start[] entries).  They are ints, for graphs of up to
+// INT_MAX arcs (each edge counts twice); built with "make INDEX64=1" they
+// are 64-bit.  Vertex numbers are ints either way.
+
+#ifdef INDEX64
+typedef long long ARC;
+#define ARC_MAX LLONG_MAX
+#else
+typedef int ARC;
+#define ARC_MAX INT_MAX
+#endif
+
+// Vertex orderings
+
+#define ORDER_NONE   0
+#define ORDER_RCM    1
+#define ORDER_BFS    2
+#define ORDER_DEGREE 3
+
+int graph_order_from_name(const char *name);
+int graph_order(int n, const ARC *start, const int *adj, int method,
+                const int *roots, int *order);
+int graph_permute(int n, const ARC *start, const int *adj, const int *order,
+                  ARC *newstart, int *newadj);
+int graph_bandwidth(int n, const ARC *start, const int *adj);
+int graph_terminal_distances(int n, const ARC *start, const int *adj,
+                             int nterm, const int *term, int *dist);
+int graph_weighted_distances(int n, const ARC *start, const int *adj,
+                             const int *weight, int source, long long *dist);
+int graph_steiner_tree(int n, const ARC *start, const int *adj,
+                       const int *weight, int nterm, const int *term,
+                       int *parent, int *order, int *count);
+int graph_greedy_grow(int n, const ARC *start, const int *adj,
+                      const int *cost, const int *value, double budget,
+                      long long *spent, int *parent, int *order, int *count);
+int graph_heavy_matching(int n, const ARC *start, const int *adj,
+                         const int *weight, int *map);
+int graph_contract(int n, const ARC *start, const int *adj,
+                   const int *weight, const int *map, int nc,
+                   ARC *cstart, int *cadj, int *cweight);
+int graph_partition(int n, const ARC *start, const int *adj, int k,
+                    int *part);
+
+#endif
@@ -0,0 +1,337 @@
+// Functions to read raster grids, such as land value or habitat suitability
+// maps, a strip of rows at a time
+//
+// Two kinds of files are read:
+//
+//   ESRI ASCII grids (.asc) -- a header of "key value" lines (ncols, nrows,
+//     xllcorner or xllcenter, yllcorner or yllcenter, cellsize and the
+//     optional NODATA_value, -9999 if not given), followed by the values of
+//     the cells, row by row from the top, separated by white space
+//   binary rasters (any other extension, such as .flt or .bil) -- the
+//     values of the cells, row by row from the top, described by a header
+//     file of the same name with the extension .hdr.  Its keys are ncols,
+//     nrows, nodata (or nodata_value), byteorder (LSBFIRST or I, MSBFIRST
+//     or M), nbits (8, 16, 32 or 64), pixeltype (signedint, unsignedint or
+//     float), skipbytes and nbands, which must be 1; other keys are ignored.
+//     A .flt file holds 32-bit floats, any other 8-bit unsigned integers,
+//     unless the header says otherwise; the byte order is LSBFIRST.
+//
+// Only the rows asked for are held in memory, so rasters of any size can
+// be read, for example to average blocks of cells one strip at a time.
+//
+// Function calls:
+//   RASTER *raster_open(const char *filename, RASTER_INFO *info)
+//     -- Opens the raster "filename" and reads its header into "info".
+//        Returns NULL, after printing the reason, if the raster cannot be
+//        read.
+//   int raster_read(RASTER *r, int rows, double *values)
+//     -- Reads the next "rows" rows of the raster into values[0] ...
+//        values[rows*cols-1], row by row.  NODATA cells (and NaN cells of
+//        float rasters) are returned as NaN.  Returns 0, or 1, after
+//        printing the reason, if the raster ends early or holds a value
+//        that is not a number.
+//   void raster_close(RASTER *r)
+//     -- Closes the raster and frees its buffers.
+
+
+// Inclusions
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "raster.h"
+
+// Constants
+
+#define TOKEN 128               // Longest number or key of a header
+
+#define PIXEL_SIGNED   0
+#define PIXEL_UNSIGNED 1
+#define PIXEL_FLOAT    2
+
+// Types
+
+struct RASTER {
+  FILE *fp;
+  int binary;             // 1 for a binary raster, 0 for an ASCII grid
+  int bytes;              // Bytes per binary value
+  int pixeltype;          // PIXEL_*
+  int msbfirst;           // 1 if binary values are big-endian
+  unsigned char *buffer;  // ASCII: bytes read ahead; binary: one row
+  size_t length,pos;      // Bytes in the buffer and the next one to parse
+  char pending[TOKEN];    // ASCII: first value, read with the header
+  int row;                // Rows read so far
+  RASTER_INFO info;
+};
+
+
+// Function to read the next white space separated token of an ASCII grid
+// into tok; returns its length, 0 at the end of the file
+
+static int next_token(RASTER *r, char *tok)
+{
+  int c,len=0;
+
+  for (;;) {
+    if (r->pos==r->length) {
+      r->length = fread(r->buffer,1,RASTER_BUFFER,r->fp);
+      r->pos = 0;
+      if (r->length==0) break;
+    }
+    c = r->buffer[r->pos];
+    if (isspace(c)) {
+      r->pos++;
+      if (len>0) break;
+      continue;
+    }
+    if (len<TOKEN-1) tok[len++] = (char)c;
+    r->pos++;
+  }
+  tok[len] = '\0';
+  return len;
+}
+
+
+// Function to read the header of an ASCII grid, up to its first value
+
+static int read_ascii_header(RASTER *r)
+{
+  char key[TOKEN],value[TOKEN];
+  double v;
+  char *end;
+
+  for (;;) {
+    if (next_token(r,key)==0) return 1;
+    if (!isalpha((unsigned char)key[0])) break;
+    if (next_token(r,value)==0) return 1;
+    v = strtod(value,&end);
+    if (*end!='\0') return 1;
+    if (strcasecmp(key,"ncols")==0) r->info.cols = (int)v;
+    else if (strcasecmp(key,"nrows")==0) r->info.rows = (int)v;
+    else if ((strcasecmp(key,"xllcorner")==0)||
+             (strcasecmp(key,"xllcenter")==0)) r->info.xll = v;
+    else if ((strcasecmp(key,"yllcorner")==0)||
+             (strcasecmp(key,"yllcenter")==0)) r->info.yll = v;
+    else if ((strcasecmp(key,"cellsize")==0)||
+             (strcasecmp(key,"dx")==0)) r->info.cellsize = v;
+    else if (strcasecmp(key,"nodata_value")==0) r->info.nodata = v;
+    else if (strcasecmp(key,"dy")!=0) return 1;
+  }
+  strcpy(r->pending,key);
+  return 0;
+}
+
+
+// Function to read the .hdr file of a binary raster
+
+static int read_binary_header(RASTER *r, const char *filename)
+{
+  char *hdrname,*dot,*slash;
+  char line[1024],key[TOKEN],value[TOKEN];
+  FILE *fp;
+  long skip=0;
+  int nbits,nbands=1;
+
+  hdrname = malloc(strlen(filename)+5);
+  if (hdrname==NULL) return 1;
+  strcpy(hdrname,filename);
+  dot = strrchr(hdrname,'.');
+  slash = strrchr(hdrname,'/');
+  if ((dot!=NULL)&&((slash==NULL)||(dot>slash))) {
+    if (strcasecmp(dot,".flt")==0) r->pixeltype = PIXEL_FLOAT;
+    strcpy(dot,".hdr");
+  } else strcat(hdrname,".hdr");
+  fp = fopen(hdrname,"r");
+  if (fp==NULL) {
+    fprintf(stderr,"Cannot open the raster header %s\n",hdrname);
+    free(hdrname);
+    return 1;
+  }
+  free(hdrname);
+
+  nbits = (r->pixeltype==PIXEL_FLOAT) ? 32 : 8;
+  while (fgets(line,sizeof(line),fp)!=NULL) {
+    if (sscanf(line,"%127s %127s",key,value)!=2) continue;
+    if (strcasecmp(key,"ncols")==0) r->info.cols = atoi(value);
+    else if (strcasecmp(key,"nrows")==0) r->info.rows = atoi(value);
+    else if ((strcasecmp(key,"xllcorner")==0)||
+             (strcasecmp(key,"xllcenter")==0)) r->info.xll = atof(value);
+    else if ((strcasecmp(key,"yllcorner")==0)||
+             (strcasecmp(key,"yllcenter")==0)) r->info.yll = atof(value);
+    else if (strcasecmp(key,"cellsize")==0) r->info.cellsize = atof(value);
+    else if ((strcasecmp(key,"nodata")==0)||
+             (strcasecmp(key,"nodata_value")==0)) {
+      r->info.hasnodata = 1;
+      r->info.nodata = atof(value);
+    } else if (strcasecmp(key,"byteorder")==0) {
+      r->msbfirst = ((strcasecmp(value,"msbfirst")==0)||
+                     (strcasecmp(value,"m")==0));
+    } else if (strcasecmp(key,"nbits")==0) nbits = atoi(value);
+    else if (strcasecmp(key,"nbands")==0) nbands = atoi(value);
+    else if (strcasecmp(key,"skipbytes")==0) skip = atol(value);
+    else if (strcasecmp(key,"pixeltype")==0) {
+      if (strcasecmp(value,"signedint")==0) r->pixeltype = PIXEL_SIGNED;
+      else if (strcasecmp(value,"unsignedint")==0) r->pixeltype = PIXEL_UNSIGNED;
+      else if (strcasecmp(value,"float")==0) r->pixeltype = PIXEL_FLOAT;
+      else {
+	fprintf(stderr,"Unknown pixeltype %s\n",value);
+	fclose(fp);
+	return 1;
+      }
+    }
+  }
+  fclose(fp);
+
+  if (nbands!=1) {
+    fprintf(stderr,"Rasters of %d bands are not supported\n",nbands);
+    return 1;
+  }
+  if ((nbits!=8)&&(nbits!=16)&&(nbits!=32)&&(nbits!=64)) {
+    fprintf(stderr,"Rasters of %d bits per value are not supported\n",nbits);
+    return 1;
+  }
+  if ((r->pixeltype==PIXEL_FLOAT)&&(nbits<32)) {
+    fprintf(stderr,"Float rasters must have 32 or 64 bits per value\n");
+    return 1;
+  }
+  r->bytes = nbits/8;
+  if ((skip>0)&&(fseek(r->fp,skip,SEEK_SET)!=0)) return 1;
+
+  // A 32-bit float raster holds its NODATA value rounded to float
+  if ((r->pixeltype==PIXEL_FLOAT)&&(r->bytes==4))
+    r->info.nodata = (float)r->info.nodata;
+  return 0;
+}
+
+
+RASTER *raster_open(const char *filename, RASTER_INFO *info)
+{
+  RASTER *r;
+  const char *dot;
+  int result;
+
+  r = calloc(1,sizeof(RASTER));
+  if (r==NULL) return NULL;
+  r->fp = fopen(filename,"rb");
+  if (r->fp==NULL) {
+    fprintf(stderr,"Cannot open the raster %s\n",filename);
+    free(r);
+    return NULL;
+  }
+  r->pixeltype = PIXEL_UNSIGNED;
+  dot = strrchr(filename,'.');
+  r->binary = !((dot!=NULL)&&(strcasecmp(dot,".asc")==0));
+  r->info.rows = r->info.cols = -1;
+  if (r->binary) {
+    result = read_binary_header(r,filename);
+  } else {
+    r->info.hasnodata = 1;
+    r->info.nodata = -9999;
+    r->buffer = malloc(RASTER_BUFFER);
+    result = (r->buffer==NULL) ? 1 : read_ascii_header(r);
+    if (result!=0) fprintf(stderr,"Bad header in the raster %s\n",filename);
+  }
+  if ((result==0)&&((r->info.rows<=0)||(r->info.cols<=0))) {
+    fprintf(stderr,"The raster %s has no ncols or nrows\n",filename);
+    result = 1;
+  }
+  if ((result==0)&&r->binary) {
+    r->buffer = malloc((size_t)r->info.cols*r->bytes);
+    if (r->buffer==NULL) result = 1;
+  }
+  if (result!=0) {
+    raster_close(r);
+    return NULL;
+  }
+  *info = r->info;
+  return r;
+}
+
+
+// Function to convert the binary value at p to a double
+
+static double binary_value(RASTER *r, const unsigned char *p)
+{
+  unsigned char b[8];
+  unsigned long long u=0;
+  float f;
+  double d;
+  int k,n=r->bytes;
+
+  for (k=0; k<n; k++) b[k] = r->msbfirst ? p[k] : p[n-1-k];
+  for (k=0; k<n; k++) u = (u << 8) | b[k];
+
+  if (r->pixeltype==PIXEL_FLOAT) {
+    if (n==4) {
+      unsigned int u32 = (unsigned int)u;
+      memcpy(&f,&u32,4);
+      return f;
+    }
+    memcpy(&d,&u,8);
+    return d;
+  }
+  if ((r->pixeltype==PIXEL_SIGNED)&&(n<8)&&(u>>(8*n-1)))
+    return (double)(long long)(u - (1ULL << (8*n)));
+  if (r->pixeltype==PIXEL_SIGNED) return (double)(long long)u;
+  return (double)u;
+}
+
+
+int raster_read(RASTER *r, int rows, double *values)
+{
+  char tok[TOKEN];
+  char *end;
+  long long k,n;
+  int i,j;
+
+  if (rows>r->info.rows-r->row) {
+    fprintf(stderr,"Read past the last row of the raster\n");
+    return 1;
+  }
+  if (r->binary) {
+    for (i=0; i<rows; i++) {
+      if (fread(r->buffer,r->bytes,r->info.cols,r->fp)!=(size_t)r->info.cols) {
+	fprintf(stderr,"The raster ends in row %d\n",r->row+i);
+	return 1;
+      }
+      for (j=0; j<r->info.cols; j++)
+	values[(long long)i*r->info.cols+j] = binary_value(r,r->buffer+(size_t)j*r->bytes);
+    }
+  } else {
+    n = (long long)rows*r->info.cols;
+    for (k=0; k<n; k++) {
+      if (r->pending[0]!='\0') {
+	strcpy(tok,r->pending);
+	r->pending[0] = '\0';
+      } else if (next_token(r,tok)==0) {
+	fprintf(stderr,"The raster ends in row %lld\n",r->row+k/r->info.cols);
+	return 1;
+      }
+      values[k] = strtod(tok,&end);
+      if (*end!='\0') {
+	fprintf(stderr,"Bad value %s in row %lld of the raster\n",tok,
+		r->row+k/r->info.cols);
+	return 1;
+      }
+    }
+  }
+
+  n = (long long)rows*r->info.cols;
+  for (k=0; k<n; k++) {
+    if (r->info.hasnodata&&(values[k]==r->info.nodata)) values[k] = NAN;
+  }
+  r->row += rows;
+  return 0;
+}
+
+
+void raster_close(RASTER *r)
+{
+  if (r->fp!=NULL) fclose(r->fp);
+  free(r->buffer);
+  free(r);
+}
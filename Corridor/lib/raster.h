@@ -0,0 +1,22 @@
+// Header file for the strip-by-strip reader of ESRI ASCII and binary rasters
+
+#ifndef _RASTER_H
+#define _RASTER_H
+
+#define RASTER_BUFFER (1 << 20)    // Bytes read from the file at once
+
+typedef struct {
+  int rows,cols;
+  double xll,yll;                  // Lower left corner (or center) of the grid
+  double cellsize;
+  int hasnodata;                   // 1 if the header declares a NODATA value
+  double nodata;
+} RASTER_INFO;
+
+typedef struct RASTER RASTER;
+
+RASTER *raster_open(const char *filename, RASTER_INFO *info);
+int raster_read(RASTER *r, int rows, double *values);
+void raster_close(RASTER *r);
+
+#endif
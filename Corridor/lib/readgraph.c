@@ -0,0 +1,1065 @@
+// Functions to read graphs stored as GML files, DIMACS files (.clq, .col),
+// plain edge lists or METIS adjacency files into compressed sparse row (CSR)
+// arrays
+//
+// The file is memory-mapped and cut into one chunk per thread, each chunk
+// starting at the beginning of a line (for GML, of a top-level node or edge
+// block).  Every thread parses its chunk into a private buffer of (u,v)
+// pairs; the buffers are then merged into the CSR arrays by a counting sort
+// on the vertex degrees.
+//
+// Function calls:
+//   int read_graph_file(const char *filename, int format, int nthreads,
+//                       int *nvertices, ARC **start, int **adj)
+//     -- Reads the graph stored in "filename" in the given format (one of
+//        the GRAPH_* constants of readgraph.h) using "nthreads" threads.
+//        On return the neighbors of vertex i are adj[start[i]] ...
+//        adj[start[i+1]-1].  For DIMACS, edge lists and METIS they are in
+//        increasing order, without self loops or duplicates, and every edge
+//        is stored in both directions.  For GML they are in the order of
+//        the edges in the file, exactly as Mark Newman's readgml.c stored
+//        them: an undirected edge is stored in both directions (a self loop
+//        twice), and a directed one only at its source.  Returns 0 if the
+//        read was successful; a graph of more than ARC_MAX arcs (see
+//        graphutil.h) or INT_MAX vertices is refused.
+//   int graph_format_from_name(const char *name)
+//     -- Returns the format called "name" (gml, dimacs, edgelist, metis),
+//        or -1 if there is no such format.
+//   int graph_format_from_extension(const char *filename)
+//     -- Guesses the format from the extension of "filename"; files with
+//        an unknown extension are taken to be GML.
+//
+// Vertex numbering:
+//   DIMACS   -- "p edge n m" declares vertices 1..n; "e u v" lines are edges
+//   METIS    -- the header "n m [fmt [ncon]]" is followed by one line per
+//               vertex listing its (1-based) neighbors, and weights if fmt
+//               says so; lines starting with '%' are comments
+//   GML      -- vertices are the "id"s of the node blocks, renumbered 0..n-1
+//               in increasing order; edges are the "source" and "target" of
+//               the edge blocks
+//   edgelist -- one "u v" pair per line, anything after it is ignored, and
+//               lines starting with '#' or '%' are comments; like GML ids,
+//               the ids need not be consecutive and are renumbered 0..n-1
+//               in increasing order
+
+
+// Inclusions
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "readgraph.h"
+
+// Constants
+
+#define MAXTHREADS 256
+
+#ifdef INDEX64
+#define ARC_HINT ""
+#else
+#define ARC_HINT "; rebuild with make INDEX64=1"
+#endif
+
+// Types
+
+typedef struct {
+  const char *begin;     // First byte of the chunk (the start of a line)
+  const char *end;       // One past the last byte of the chunk
+  int format;
+  int first;             // 1 if this chunk starts at the start of the file
+  int pass;              // METIS: 1 counts vertex lines, 2 reads them
+  long long npairs;      // Number of (u,v) pairs read
+  long long capacity;    // Number of pairs there is room for
+  int *pairs;            // u0 v0 u1 v1 ...
+  int hasheader;         // 1 if the DIMACS "p" line or METIS header was here
+  long long n;           // Number of vertices declared in the header
+  int fmt;               // METIS fmt field, e.g. 11 for vertex+edge weights
+  int ncon;              // METIS number of vertex weights
+  long long base;        // METIS: vertex number of the first line in chunk
+  long long nlines;      // METIS: number of vertex lines in the chunk
+  long long minid;       // Smallest id seen (edge lists)
+  long long maxid;       // Largest id seen (edge lists)
+  long long errline;     // Offset of the first bad line, or -1
+  int *ids;              // GML: node ids read
+  long long nids;        // GML: number of node ids read
+  long long idcapacity;  // GML: number of ids there is room for
+  int directed;          // GML: value of "directed", or -1 if not seen
+  int depth;             // GML: bracket depth at the end of the chunk
+} CHUNK;
+
+typedef struct {
+  ARC *start;
+  int *adj;
+  ARC *deg;
+  int from,to;           // Range of vertices to sort
+} SORTJOB;
+
+
+// Functions to map format names and file extensions to formats
+
+int graph_format_from_name(const char *name)
+{
+  if (strcmp(name,"gml")==0) return GRAPH_GML;
+  if (strcmp(name,"dimacs")==0) return GRAPH_DIMACS;
+  if (strcmp(name,"edgelist")==0) return GRAPH_EDGELIST;
+  if (strcmp(name,"metis")==0) return GRAPH_METIS;
+  return -1;
+}
+
+int graph_format_from_extension(const char *filename)
+{
+  const char *ext;
+
+  ext = strrchr(filename,'.');
+  if (ext==NULL) return GRAPH_GML;
+  ext++;
+  if ((strcmp(ext,"clq")==0)||(strcmp(ext,"col")==0)||
+      (strcmp(ext,"dimacs")==0)) return GRAPH_DIMACS;
+  if ((strcmp(ext,"txt")==0)||(strcmp(ext,"el")==0)||
+      (strcmp(ext,"edges")==0)||(strcmp(ext,"edgelist")==0))
+    return GRAPH_EDGELIST;
+  if ((strcmp(ext,"graph")==0)||(strcmp(ext,"metis")==0)) return GRAPH_METIS;
+  return GRAPH_GML;
+}
+
+
+// Scanner functions.  They never read past "end", so the mapped file needs
+// no terminating NUL.
+
+static const char *skip_blanks(const char *p, const char *end)
+{
+  while ((p<end)&&((*p==' ')||(*p=='\t')||(*p=='\r'))) p++;
+  return p;
+}
+
+static const char *skip_word(const char *p, const char *end)
+{
+  while ((p<end)&&(*p!=' ')&&(*p!='\t')&&(*p!='\r')&&(*p!='\n')) p++;
+  return p;
+}
+
+// Reads a non-negative integer after optional blanks.  Returns a pointer
+// past it, or NULL if there is none or it does not fit in an int.
+
+static const char *scan_int(const char *p, const char *end, long long *value)
+{
+  long long v=0;
+
+  p = skip_blanks(p,end);
+  if ((p>=end)||(*p<'0')||(*p>'9')) return NULL;
+  while ((p<end)&&(*p>='0')&&(*p<='9')) {
+    v = 10*v + (*p-'0');
+    if (v>INT_MAX) return NULL;
+    p++;
+  }
+  *value = v;
+  return p;
+}
+
+static const char *end_of_line(const char *p, const char *end)
+{
+  const char *q;
+
+  q = memchr(p,'\n',end-p);
+  return (q==NULL) ? end : q;
+}
+
+
+// Function to append a pair to the buffer of a chunk
+
+static int add_pair(CHUNK *c, long long u, long long v)
+{
+  if (c->npairs==c->capacity) {
+    c->capacity = (c->capacity==0) ? 65536 : 2*c->capacity;
+    c->pairs = realloc(c->pairs,2*c->capacity*sizeof(int));
+    if (c->pairs==NULL) return 1;
+  }
+  c->pairs[2*c->npairs] = (int)u;
+  c->pairs[2*c->npairs+1] = (int)v;
+  c->npairs++;
+  if (u<c->minid) c->minid = u;
+  if (v<c->minid) c->minid = v;
+  if (u>c->maxid) c->maxid = u;
+  if (v>c->maxid) c->maxid = v;
+  return 0;
+}
+
+
+// Functions to parse one line of each format.  "p" is the start of the
+// line and "eol" its end.  Return 0 if the line was fine.
+
+static int parse_dimacs_line(CHUNK *c, const char *p, const char *eol)
+{
+  long long u,v,m;
+
+  p = skip_blanks(p,eol);
+  if (p==eol) return 0;
+  if (*p=='e') {
+    if ((p=scan_int(p+1,eol,&u))==NULL) return 1;
+    if ((p=scan_int(p,eol,&v))==NULL) return 1;
+    return add_pair(c,u,v);
+  }
+  if (*p=='p') {
+    p = skip_word(skip_blanks(p+1,eol),eol);    // "edge" or "col"
+    if ((p=scan_int(p,eol,&c->n))==NULL) return 1;
+    if ((p=scan_int(p,eol,&m))==NULL) return 1;
+    c->hasheader = 1;
+  }
+  return 0;                  // Comments and other line types are skipped
+}
+
+static int parse_edgelist_line(CHUNK *c, const char *p, const char *eol)
+{
+  long long u,v;
+
+  p = skip_blanks(p,eol);
+  if ((p==eol)||(*p=='#')||(*p=='%')) return 0;
+  if ((p=scan_int(p,eol,&u))==NULL) return 1;
+  if ((p=scan_int(p,eol,&v))==NULL) return 1;
+  return add_pair(c,u,v);
+}
+
+static int parse_metis_header(CHUNK *c, const char *p, const char *eol)
+{
+  long long m,value;
+
+  if ((p=scan_int(p,eol,&c->n))==NULL) return 1;
+  if ((p=scan_int(p,eol,&m))==NULL) return 1;
+  c->fmt = 0;
+  c->ncon = 1;
+  if ((p=scan_int(p,eol,&value))!=NULL) {
+    c->fmt = (int)value;
+    if ((p=scan_int(p,eol,&value))!=NULL) c->ncon = (int)value;
+  }
+  c->hasheader = 1;
+  return 0;
+}
+
+static int parse_metis_line(CHUNK *c, long long vertex, const char *p,
+                            const char *eol)
+{
+  int i;
+  long long v,w;
+
+  if ((c->fmt/100)%10) {                          // Vertex size
+    if ((p=scan_int(p,eol,&w))==NULL) return 1;
+  }
+  if ((c->fmt/10)%10) {                           // Vertex weights
+    for (i=0; i<c->ncon; i++) {
+      if ((p=scan_int(p,eol,&w))==NULL) return 1;
+    }
+  }
+  while ((p=scan_int(p,eol,&v))!=NULL) {
+    if (c->fmt%10) {                              // Edge weight
+      if ((p=scan_int(p,eol,&w))==NULL) return 1;
+    }
+    if (add_pair(c,vertex,v)!=0) return 1;
+  }
+  return 0;
+}
+
+
+
+
+// GML.  The file is a nested list of "key value" pairs, a value being a
+// number, a "string" or a list [ ... ].  Only the id of each top-level
+// node block and the source and target of each top-level edge block are
+// used, and "directed" at the graph level.  Chunks start at a line whose
+// first word is "node" or "edge" and that opens a block, so every chunk
+// but the first starts at depth 1, inside "graph [".
+
+static int is_word_char(char ch)
+{
+  return ((ch>='a')&&(ch<='z'))||((ch>='A')&&(ch<='Z'))||
+    ((ch>='0')&&(ch<='9'))||(ch=='_');
+}
+
+// Skips blanks, newlines and comments ('#' or "//" to the end of the line)
+
+static const char *skip_space(const char *p, const char *end)
+{
+  while (p<end) {
+    if ((*p==' ')||(*p=='\t')||(*p=='\r')||(*p=='\n')) p++;
+    else if ((*p=='#')||((*p=='/')&&(p+1<end)&&(p[1]=='/')))
+      p = end_of_line(p,end);
+    else break;
+  }
+  return p;
+}
+
+// Returns 1 if the line at p starts a top-level node or edge block
+
+static int gml_block_start(const char *p, const char *end)
+{
+  p = skip_blanks(p,end);
+  if ((end-p<4)||((strncmp(p,"node",4)!=0)&&(strncmp(p,"edge",4)!=0)))
+    return 0;
+  p += 4;
+  if ((p<end)&&is_word_char(*p)) return 0;
+  p = skip_space(p,end);
+  return (p<end)&&(*p=='[');
+}
+
+// Function to append a node id to the buffer of a chunk
+
+static int add_id(CHUNK *c, long long id)
+{
+  if (c->nids==c->idcapacity) {
+    c->idcapacity = (c->idcapacity==0) ? 65536 : 2*c->idcapacity;
+    c->ids = realloc(c->ids,c->idcapacity*sizeof(int));
+    if (c->ids==NULL) return 1;
+  }
+  c->ids[c->nids++] = (int)id;
+  return 0;
+}
+
+// Reads a GML number; sets *isint if it is an integer that fits in an int
+
+static const char *scan_number(const char *p, const char *end,
+                               long long *value, int *isint)
+{
+  const char *q = p;
+  long long v=0;
+  int neg=0;
+
+  *isint = 1;
+  if ((q<end)&&((*q=='-')||(*q=='+'))) neg = (*q++=='-');
+  if ((q>=end)||(((*q<'0')||(*q>'9'))&&(*q!='.'))) return NULL;
+  while ((q<end)&&(*q>='0')&&(*q<='9')) {
+    v = 10*v + (*q-'0');
+    if (v>INT_MAX) *isint = 0;
+    q++;
+  }
+  while ((q<end)&&(((*q>='0')&&(*q<='9'))||(*q=='.')||(*q=='e')||
+		   (*q=='E')||(*q=='-')||(*q=='+'))) {
+    *isint = 0;
+    q++;
+  }
+  *value = neg ? -v : v;
+  return q;
+}
+
+static void parse_gml_chunk(CHUNK *c)
+{
+  const char *p = c->begin, *q;
+  const char *end = c->end;
+  int depth,block=0,blockdepth=0,isint;
+  char key[16];
+  long long value=0,id=0,s=0,t=0;
+  int hasid=0,hass=0,hast=0,open=0;
+
+  depth = c->first ? 0 : 1;
+  key[0] = '\0';
+  while ((p=skip_space(p,end))<end) {
+    if (*p=='[') {
+      depth++;
+      if ((block==0)&&(depth==2)&&
+	  ((strcmp(key,"node")==0)||(strcmp(key,"edge")==0))) {
+	block = (key[0]=='n') ? 1 : 2;
+	blockdepth = depth;
+	hasid = hass = hast = 0;
+      }
+      key[0] = '\0';
+      p++;
+    } else if (*p==']') {
+      if (block&&(depth==blockdepth)) {
+	if ((block==1)&&hasid) {
+	  if (add_id(c,id)!=0) c->errline = p - c->begin;
+	} else if ((block==1)&&(c->errline<0)) c->errline = p - c->begin;
+	if ((block==2)&&hass&&hast) {
+	  if (add_pair(c,s,t)!=0) c->errline = p - c->begin;
+	}
+	block = 0;
+      }
+      depth--;
+      if ((depth<0)&&(c->errline<0)) c->errline = p - c->begin;
+      key[0] = '\0';
+      p++;
+    } else if (*p=='"') {
+      q = memchr(p+1,'"',end-p-1);
+      if (q==NULL) open = 1;
+      p = (q==NULL) ? end : q + 1;
+      key[0] = '\0';
+    } else if (((*p>='0')&&(*p<='9'))||(*p=='-')||(*p=='+')||(*p=='.')) {
+      q = scan_number(p,end,&value,&isint);
+      if (q==NULL) {
+	if (c->errline<0) c->errline = p - c->begin;
+	q = skip_word(p,end);
+      }
+      if (block&&(depth==blockdepth)&&(q!=NULL)) {
+	if (((strcmp(key,"id")==0)||(strcmp(key,"source")==0)||
+	     (strcmp(key,"target")==0))&&!isint) {
+	  if (c->errline<0) c->errline = p - c->begin;
+	} else if (strcmp(key,"id")==0) id = value, hasid = 1;
+	else if (strcmp(key,"source")==0) s = value, hass = 1;
+	else if (strcmp(key,"target")==0) t = value, hast = 1;
+      } else if ((depth==1)&&(strcmp(key,"directed")==0)) {
+	c->directed = (value!=0);
+      }
+      key[0] = '\0';
+      p = q;
+    } else {
+      q = p;
+      while ((q<end)&&is_word_char(*q)) q++;
+      if (q==p) q++;                           // Stray character
+      if (q-p<(long)sizeof(key)) {
+	memcpy(key,p,q-p);
+	key[q-p] = '\0';
+      } else key[0] = '\0';
+      p = q;
+    }
+  }
+  if (block&&(c->errline<0)) c->errline = end - c->begin;
+  c->depth = open ? -1 : depth;                // -1: ends inside a string
+}
+
+
+// Thread function to parse one chunk
+
+static void *parse_chunk(void *arg)
+{
+  CHUNK *c = arg;
+  const char *p,*eol;
+  long long line=0;
+  int bad;
+
+  if (c->format==GRAPH_GML) {
+    parse_gml_chunk(c);
+    return NULL;
+  }
+  for (p=c->begin; p<c->end; p=eol+1) {
+    eol = end_of_line(p,c->end);
+    bad = 0;
+    if (c->format==GRAPH_DIMACS) bad = parse_dimacs_line(c,p,eol);
+    else if (c->format==GRAPH_EDGELIST) bad = parse_edgelist_line(c,p,eol);
+    else {
+      const char *q = skip_blanks(p,eol);
+      if ((q<eol)&&(*q=='%')) continue;
+      if (c->first&&!c->hasheader) {
+	if (q==eol) continue;
+	if (c->pass==1) bad = parse_metis_header(c,q,eol);
+	else c->hasheader = 1;
+      } else {
+	if (c->pass==2) bad = parse_metis_line(c,c->base+line,q,eol);
+	line++;
+      }
+    }
+    if (bad&&(c->errline<0)) c->errline = p - c->begin;
+    if (eol==c->end) break;
+  }
+  c->nlines = line;
+  return NULL;
+}
+
+
+// Function to run "fn" on each of the "njobs" jobs of size "size" stored
+// at "jobs", one thread each; the first job runs in the calling thread
+
+static void run_jobs(void *(*fn)(void *), void *jobs, size_t size, int njobs)
+{
+  int i;
+  int started[MAXTHREADS];
+  pthread_t thread[MAXTHREADS];
+
+  for (i=1; i<njobs; i++) {
+    started[i] = (pthread_create(&thread[i],NULL,fn,(char *)jobs+i*size)==0);
+    if (!started[i]) fn((char *)jobs+i*size);
+  }
+  fn(jobs);
+  for (i=1; i<njobs; i++) {
+    if (started[i]) pthread_join(thread[i],NULL);
+  }
+}
+
+static void run_chunks(CHUNK *chunk, int nchunks)
+{
+  run_jobs(parse_chunk,chunk,sizeof(CHUNK),nchunks);
+}
+
+
+// Function to sort the neighbor lists of a range of vertices and remove
+// duplicates; deg[i] is set to the number of distinct neighbors of i
+
+static int cmpint(const void *a, const void *b)
+{
+  int x = *(const int *)a;
+  int y = *(const int *)b;
+  return (x>y) - (x<y);
+}
+
+static void *sort_lists(void *arg)
+{
+  SORTJOB *job = arg;
+  int i;
+  ARC k,w;
+  int *list;
+
+  for (i=job->from; i<job->to; i++) {
+    list = job->adj + job->start[i];
+    qsort(list,job->start[i+1]-job->start[i],sizeof(int),cmpint);
+    w = 0;
+    for (k=0; k<job->start[i+1]-job->start[i]; k++) {
+      if ((w==0)||(list[k]!=list[w-1])) list[w++] = list[k];
+    }
+    job->deg[i] = w;
+  }
+  return NULL;
+}
+
+
+// Function to build the CSR arrays from the pairs of all chunks; "map"
+// translates the ids of the file into vertex numbers (NULL for DIMACS and
+// METIS, whose ids are 1-based), "ids" is the sorted list of distinct ids
+// when the ids are too sparse for a map
+
+static int build_csr(CHUNK *chunk, int nchunks, int nthreads, int n,
+                     int *map, long long minid, int *ids,
+                     ARC **startp, int **adjp)
+{
+  int i,t,u,v;
+  long long k,arcs;
+  ARC *start,*pos,*deg,from;
+  int *adj=NULL,*shrunk;
+  int *key;
+  int result=1;
+  SORTJOB job[MAXTHREADS];
+
+  deg = calloc(n+1,sizeof(ARC));
+  start = malloc((n+1)*sizeof(ARC));
+  if ((deg==NULL)||(start==NULL)) goto done;
+
+  // Translate ids into vertex numbers and count the degrees
+
+  arcs = 0;
+  for (t=0; t<nchunks; t++) {
+    for (k=0; k<2*chunk[t].npairs; k++) {
+      u = chunk[t].pairs[k];
+      if (map!=NULL) u = map[u-minid];
+      else if (ids!=NULL) {
+	key = bsearch(&u,ids,n,sizeof(int),cmpint);
+	u = (int)(key-ids);
+      } else {
+	if ((u<1)||(u>n)) {
+	  fprintf(stderr,"Vertex %d out of range [1,%d]\n",u,n);
+	  goto done;
+	}
+	u--;
+      }
+      chunk[t].pairs[k] = u;
+    }
+    for (k=0; k<chunk[t].npairs; k++) {
+      u = chunk[t].pairs[2*k];
+      v = chunk[t].pairs[2*k+1];
+      if (u==v) continue;
+      deg[u]++;
+      deg[v]++;
+      arcs += 2;
+    }
+  }
+  if (arcs>ARC_MAX) {
+    fprintf(stderr,"Too many edges (%lld)%s\n",arcs/2,ARC_HINT);
+    goto done;
+  }
+
+  // Counting sort of the pairs into the neighbor lists
+
+  start[0] = 0;
+  for (i=0; i<n; i++) start[i+1] = start[i] + deg[i];
+  adj = malloc((arcs>0 ? arcs : 1)*sizeof(int));
+  if (adj==NULL) goto done;
+  pos = deg;
+  for (i=0; i<n; i++) pos[i] = start[i];
+  for (t=0; t<nchunks; t++) {
+    for (k=0; k<chunk[t].npairs; k++) {
+      u = chunk[t].pairs[2*k];
+      v = chunk[t].pairs[2*k+1];
+      if (u==v) continue;
+      adj[pos[u]++] = v;
+      adj[pos[v]++] = u;
+    }
+    free(chunk[t].pairs);
+    chunk[t].pairs = NULL;
+  }
+
+  // Sort and deduplicate the lists in parallel, then close the gaps
+
+  if (nthreads>n) nthreads = (n>0) ? n : 1;
+  for (t=0; t<nthreads; t++) {
+    job[t].start = start;
+    job[t].adj = adj;
+    job[t].deg = deg;
+    job[t].from = (int)(((long long)n*t)/nthreads);
+    job[t].to = (int)(((long long)n*(t+1))/nthreads);
+  }
+  run_jobs(sort_lists,job,sizeof(SORTJOB),nthreads);
+
+  k = 0;
+  for (i=0; i<n; i++) {
+    from = start[i];
+    start[i] = (ARC)k;
+    memmove(adj+k,adj+from,deg[i]*sizeof(int));
+    k += deg[i];
+  }
+  start[n] = (ARC)k;
+  shrunk = realloc(adj,(k>0 ? k : 1)*sizeof(int));
+  if (shrunk!=NULL) adj = shrunk;
+
+  *startp = start;
+  *adjp = adj;
+  start = NULL;
+  adj = NULL;
+  result = 0;
+
+ done:
+  free(deg);
+  free(start);
+  free(adj);
+  return result;
+}
+
+
+// Function to renumber the ids of an edge list; sets either "map" (dense
+// ids) or "ids" (sparse ids) and returns the number of distinct ids, or -1
+// if out of memory
+
+static int number_ids(CHUNK *chunk, int nchunks, long long minid,
+                      long long maxid, int **mapp, int **idsp)
+{
+  int t,n;
+  long long k,range,total;
+  int *map,*ids,*shrunk;
+
+  total = 0;
+  for (t=0; t<nchunks; t++) total += 2*chunk[t].npairs;
+  range = maxid - minid + 1;
+  *mapp = *idsp = NULL;
+
+  if (range<=total+(1<<20)) {
+    map = calloc(range,sizeof(int));
+    if (map==NULL) return -1;
+    for (t=0; t<nchunks; t++) {
+      for (k=0; k<2*chunk[t].npairs; k++) map[chunk[t].pairs[k]-minid] = 1;
+    }
+    n = 0;
+    for (k=0; k<range; k++) {
+      if (map[k]) map[k] = n++;
+    }
+    *mapp = map;
+    return n;
+  }
+
+  ids = malloc((total>0 ? total : 1)*sizeof(int));
+  if (ids==NULL) return -1;
+  total = 0;
+  for (t=0; t<nchunks; t++) {
+    memcpy(ids+total,chunk[t].pairs,2*chunk[t].npairs*sizeof(int));
+    total += 2*chunk[t].npairs;
+  }
+  qsort(ids,total,sizeof(int),cmpint);
+  n = 0;
+  for (k=0; k<total; k++) {
+    if ((n==0)||(ids[k]!=ids[n-1])) ids[n++] = ids[k];
+  }
+  shrunk = realloc(ids,(n>0 ? n : 1)*sizeof(int));
+  *idsp = (shrunk!=NULL) ? shrunk : ids;
+  return n;
+}
+
+
+// Parallel merge of the GML chunks.  The neighbors of every vertex are kept
+// in the order of the edges in the file, as read_network() of readgml.c
+// stored them: chunk t writes its arcs into vertex u from the position
+// start[u] + (arcs into u of the chunks before t), so a counting sort in
+// which every chunk scatters its own pairs gives the same lists.
+
+typedef struct {
+  CHUNK *chunk;
+  ARC **count;           // count[t][u]: arcs of chunk t out of u, then offsets
+  int nchunks;
+  int n;
+  const int *map;        // Dense ids: vertex of id minid+k, or -1
+  long long minid;
+  long long range;       // Number of entries of map
+  const int *ids;        // Sparse ids: sorted ids of the vertices
+  int directed;
+  ARC *start;
+  int *adj;
+  int t;                 // Chunk of this job
+  int from,to;           // Vertex range of this job
+  long long badid;       // An edge end that is not a node id, or LLONG_MIN
+} GMLJOB;
+
+static void *gml_count(void *arg)
+{
+  GMLJOB *job = arg;
+  CHUNK *c = &job->chunk[job->t];
+  ARC *count = job->count[job->t];
+  long long k,id;
+  int u,*key;
+
+  for (k=0; k<2*c->npairs; k++) {
+    id = c->pairs[k];
+    if (job->map!=NULL) {
+      u = ((id>=job->minid)&&(id-job->minid<job->range)) ?
+	job->map[id-job->minid] : -1;
+    } else {
+      key = bsearch(&c->pairs[k],job->ids,job->n,sizeof(int),cmpint);
+      u = (key==NULL) ? -1 : (int)(key-job->ids);
+    }
+    if (u<0) {
+      job->badid = id;
+      return NULL;
+    }
+    c->pairs[k] = u;
+  }
+  for (k=0; k<c->npairs; k++) {
+    count[c->pairs[2*k]]++;
+    if (!job->directed) count[c->pairs[2*k+1]]++;
+  }
+  return NULL;
+}
+
+static void *gml_offsets(void *arg)
+{
+  GMLJOB *job = arg;
+  int t,u;
+  ARC deg;
+
+  for (u=job->from; u<job->to; u++) {
+    deg = 0;
+    for (t=0; t<job->nchunks; t++) deg += job->count[t][u];
+    job->start[u+1] = deg;
+  }
+  return NULL;
+}
+
+static void *gml_positions(void *arg)
+{
+  GMLJOB *job = arg;
+  int t,u;
+  ARC pos,cnt;
+
+  for (u=job->from; u<job->to; u++) {
+    pos = job->start[u];
+    for (t=0; t<job->nchunks; t++) {
+      cnt = job->count[t][u];
+      job->count[t][u] = pos;
+      pos += cnt;
+    }
+  }
+  return NULL;
+}
+
+static void *gml_scatter(void *arg)
+{
+  GMLJOB *job = arg;
+  CHUNK *c = &job->chunk[job->t];
+  ARC *pos = job->count[job->t];
+  long long k;
+  int u,v;
+
+  for (k=0; k<c->npairs; k++) {
+    u = c->pairs[2*k];
+    v = c->pairs[2*k+1];
+    job->adj[pos[u]++] = v;
+    if (!job->directed) job->adj[pos[v]++] = u;
+  }
+  return NULL;
+}
+
+static int build_gml_csr(CHUNK *chunk, int nchunks, int nthreads,
+                         int *nvertices, ARC **startp, int **adjp)
+{
+  int t,u,n,directed,result=1;
+  long long k,total,minid,maxid,arcs;
+  int *ids=NULL,*map=NULL,*adj=NULL;
+  ARC *start=NULL;
+  ARC *count[MAXTHREADS];
+  GMLJOB job[MAXTHREADS];
+
+  // The vertices are the node ids in increasing order
+
+  total = 0;
+  directed = 0;
+  for (t=0; t<nchunks; t++) {
+    total += chunk[t].nids;
+    if (chunk[t].directed>=0) directed = chunk[t].directed;
+  }
+  if (total>INT_MAX) {
+    fprintf(stderr,"Too many nodes (%lld)\n",total);
+    return 1;
+  }
+  n = (int)total;
+  ids = malloc((n>0 ? n : 1)*sizeof(int));
+  if (ids==NULL) return 1;
+  total = 0;
+  for (t=0; t<nchunks; t++) {
+    memcpy(ids+total,chunk[t].ids,chunk[t].nids*sizeof(int));
+    total += chunk[t].nids;
+  }
+  qsort(ids,n,sizeof(int),cmpint);
+  for (u=1; u<n; u++) {
+    if (ids[u]==ids[u-1]) {
+      fprintf(stderr,"Node id %d appears twice\n",ids[u]);
+      free(ids);
+      return 1;
+    }
+  }
+  minid = (n>0) ? ids[0] : 0;
+  maxid = (n>0) ? ids[n-1] : -1;
+  if (maxid-minid+1<=(long long)n+(1<<20)) {
+    map = malloc((maxid-minid+1>0 ? maxid-minid+1 : 1)*sizeof(int));
+    if (map==NULL) goto done;
+    for (k=0; k<maxid-minid+1; k++) map[k] = -1;
+    for (u=0; u<n; u++) map[ids[u]-minid] = u;
+  }
+
+  // Translate ids and count the arcs of every chunk out of every vertex
+
+  for (t=0; t<nchunks; t++) count[t] = NULL;
+  for (t=0; t<nchunks; t++) {
+    count[t] = calloc(n+1,sizeof(ARC));
+    if (count[t]==NULL) goto done;
+  }
+  for (t=0; t<MAXTHREADS; t++) {
+    job[t].chunk = chunk;
+    job[t].count = count;
+    job[t].nchunks = nchunks;
+    job[t].n = n;
+    job[t].map = map;
+    job[t].minid = minid;
+    job[t].range = maxid - minid + 1;
+    job[t].ids = ids;
+    job[t].directed = directed;
+    job[t].t = t;
+    job[t].badid = LLONG_MIN;
+  }
+  run_jobs(gml_count,job,sizeof(GMLJOB),nchunks);
+  for (t=0; t<nchunks; t++) {
+    if (job[t].badid!=LLONG_MIN) {
+      fprintf(stderr,"Edge end %lld is not a node id\n",job[t].badid);
+      goto done;
+    }
+  }
+
+  // Vertex degrees and the position of every chunk in every list
+
+  start = malloc((n+1)*sizeof(ARC));
+  if (start==NULL) goto done;
+  if (nthreads>n) nthreads = (n>0) ? n : 1;
+  for (t=0; t<nthreads; t++) {
+    job[t].start = start;
+    job[t].from = (int)(((long long)n*t)/nthreads);
+    job[t].to = (int)(((long long)n*(t+1))/nthreads);
+  }
+  run_jobs(gml_offsets,job,sizeof(GMLJOB),nthreads);
+  start[0] = 0;
+  arcs = 0;
+  for (u=0; u<n; u++) {
+    arcs += start[u+1];
+    if (arcs>ARC_MAX) {
+      fprintf(stderr,"Too many edges%s\n",ARC_HINT);
+      goto done;
+    }
+    start[u+1] = (ARC)arcs;
+  }
+  run_jobs(gml_positions,job,sizeof(GMLJOB),nthreads);
+
+  adj = malloc((arcs>0 ? arcs : 1)*sizeof(int));
+  if (adj==NULL) goto done;
+  for (t=0; t<nchunks; t++) job[t].adj = adj;
+  run_jobs(gml_scatter,job,sizeof(GMLJOB),nchunks);
+
+  *nvertices = n;
+  *startp = start;
+  *adjp = adj;
+  start = NULL;
+  adj = NULL;
+  result = 0;
+
+ done:
+  for (t=0; t<nchunks; t++) free(count[t]);
+  free(ids);
+  free(map);
+  free(start);
+  free(adj);
+  return result;
+}
+
+
+// Function to cut the file into chunks that start at the beginning of a
+// line, and for GML at the beginning of a node or edge block
+
+static void split_file(const char *data, long long size, int format,
+                       int nchunks, CHUNK *chunk)
+{
+  int t;
+  const char *p,*end = data + size;
+
+  p = data;
+  for (t=0; t<nchunks; t++) {
+    memset(&chunk[t],0,sizeof(CHUNK));
+    chunk[t].format = format;
+    chunk[t].first = (t==0);
+    chunk[t].pass = 1;
+    chunk[t].minid = LLONG_MAX;
+    chunk[t].maxid = -1;
+    chunk[t].errline = -1;
+    chunk[t].directed = -1;
+    chunk[t].begin = p;
+    if (t==nchunks-1) p = end;
+    else {
+      p = data + (size*(t+1))/nchunks;
+      if (p<chunk[t].begin) p = chunk[t].begin;
+      p = end_of_line(p,end);
+      if (p<end) p++;
+      while ((format==GRAPH_GML)&&(p<end)&&!gml_block_start(p,end)) {
+	p = end_of_line(p,end);
+	if (p<end) p++;
+      }
+    }
+    chunk[t].end = p;
+  }
+}
+
+// Returns 1 if every GML chunk ended at the depth at which the next one
+// was assumed to start; if not, a block boundary was guessed wrong (say a
+// "node [" line inside a string) and the file is read again in one chunk
+
+static int gml_chunks_agree(CHUNK *chunk, int nchunks)
+{
+  int t;
+
+  if (nchunks==1) return 1;
+  for (t=0; t<nchunks; t++) {
+    if (chunk[t].depth!=((t==nchunks-1) ? 0 : 1)) return 0;
+  }
+  return 1;
+}
+
+static void free_chunks(CHUNK *chunk, int nchunks)
+{
+  int t;
+
+  for (t=0; t<nchunks; t++) {
+    free(chunk[t].pairs);
+    free(chunk[t].ids);
+    chunk[t].pairs = chunk[t].ids = NULL;
+  }
+}
+
+
+// Function to read a complete graph file
+
+int read_graph_file(const char *filename, int format, int nthreads,
+                    int *nvertices, ARC **start, int **adj)
+{
+  int fd,t,nchunks,result;
+  long long n,lines,minid,maxid;
+  struct stat st;
+  const char *data;
+  int *map,*ids;
+  CHUNK chunk[MAXTHREADS];
+
+  if ((format!=GRAPH_GML)&&(format!=GRAPH_DIMACS)&&
+      (format!=GRAPH_EDGELIST)&&(format!=GRAPH_METIS)) return 1;
+
+  fd = open(filename,O_RDONLY);
+  if (fd<0) return 1;
+  if ((fstat(fd,&st)!=0)||(st.st_size==0)) {
+    close(fd);
+    return 1;
+  }
+  data = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if (data==MAP_FAILED) return 1;
+  madvise((void *)data,st.st_size,MADV_SEQUENTIAL);
+
+  if (nthreads<1) nthreads = 1;
+  if (nthreads>MAXTHREADS) nthreads = MAXTHREADS;
+  if (st.st_size<(1<<20)) nchunks = 1;
+  else nchunks = nthreads;
+
+  split_file(data,st.st_size,format,nchunks,chunk);
+  run_chunks(chunk,nchunks);
+
+  if ((format==GRAPH_GML)&&!gml_chunks_agree(chunk,nchunks)) {
+    free_chunks(chunk,nchunks);
+    nchunks = 1;
+    split_file(data,st.st_size,format,nchunks,chunk);
+    run_chunks(chunk,nchunks);
+  }
+
+  // METIS lines are numbered, so a second pass reads them once the first
+  // vertex of every chunk is known
+
+  if (format==GRAPH_METIS) {
+    lines = 0;
+    for (t=0; t<nchunks; t++) {
+      if (t>0) chunk[t].fmt = chunk[0].fmt, chunk[t].ncon = chunk[0].ncon;
+      chunk[t].base = lines + 1;
+      chunk[t].pass = 2;
+      chunk[t].hasheader = 0;
+      lines += chunk[t].nlines;
+    }
+    if (lines<chunk[0].n) {
+      fprintf(stderr,"METIS file has %lld vertex lines, expected %lld\n",
+	      lines,chunk[0].n);
+      munmap((void *)data,st.st_size);
+      return 1;
+    }
+    run_chunks(chunk,nchunks);
+  }
+
+  munmap((void *)data,st.st_size);
+
+  n = -1;
+  minid = LLONG_MAX;
+  maxid = -1;
+  result = 0;
+  for (t=0; t<nchunks; t++) {
+    if (chunk[t].errline>=0) {
+      fprintf(stderr,"Cannot parse line at byte %lld of %s\n",
+	      (long long)(chunk[t].begin-data)+chunk[t].errline,filename);
+      result = 1;
+    }
+    if (chunk[t].hasheader) n = chunk[t].n;
+    if (chunk[t].minid<minid) minid = chunk[t].minid;
+    if (chunk[t].maxid>maxid) maxid = chunk[t].maxid;
+  }
+  map = ids = NULL;
+  if ((result==0)&&(format==GRAPH_GML)) {
+    result = build_gml_csr(chunk,nchunks,nthreads,nvertices,start,adj);
+    free_chunks(chunk,nchunks);
+    return result;
+  }
+  if (result==0) {
+    if (format==GRAPH_EDGELIST) {
+      if (maxid<0) n = 0;
+      else n = number_ids(chunk,nchunks,minid,maxid,&map,&ids);
+      if (n<0) result = 1;
+    } else if (n<0) {
+      fprintf(stderr,"No header line in %s\n",filename);
+      result = 1;
+    } else if (n>INT_MAX) {
+      fprintf(stderr,"Too many vertices (%lld)\n",n);
+      result = 1;
+    }
+  }
+  if (result==0) {
+    result = build_csr(chunk,nchunks,nthreads,(int)n,map,minid,ids,
+		       start,adj);
+  }
+  free_chunks(chunk,nchunks);
+  free(map);
+  free(ids);
+  if (result==0) *nvertices = (int)n;
+  return result;
+}
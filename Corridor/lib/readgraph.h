@@ -0,0 +1,20 @@
+// Header file for the parsers of GML, DIMACS, edge list and METIS graph files
+
+#ifndef _READGRAPH_H
+#define _READGRAPH_H
+
+#include "graphutil.h"
+
+// Graph file formats
+
+#define GRAPH_GML      0
+#define GRAPH_DIMACS   1
+#define GRAPH_EDGELIST 2
+#define GRAPH_METIS    3
+
+int graph_format_from_name(const char *name);
+int graph_format_from_extension(const char *filename);
+int read_graph_file(const char *filename, int format, int nthreads,
+                    int *nvertices, ARC **start, int **adj);
+
+#endif
@@ -0,0 +1,213 @@
+// Functions to draw blocks of unbiased bounded random integers
+//
+// Eight xoshiro128+ generators run side by side, one per lane, and each
+// 32-bit draw x is reduced to [0,range) by Lemire's multiply-shift method:
+// the result is the high half of x*range, and the draw is rejected if the
+// low half is below 2^32 mod range.  Rejected lanes are redrawn, in lane
+// order, from a separate generator.  There is an AVX2 kernel and a scalar
+// one, chosen at run time; both give exactly the same numbers.
+//
+// Function calls:
+//   void sampler_seed(SAMPLER *g, uint64_t seed)
+//     -- Seeds all generators from "seed" (by splitmix64).
+//   void sampler_uniform(SAMPLER *g, uint32_t *out, long n, uint32_t range)
+//     -- Sets out[0] ... out[n-1] to independent uniform integers in
+//        [0,range); range must be at least 1.  Draws always come in groups
+//        of SAMPLER_LANES, so the sequence depends only on the sizes of
+//        the calls, not on the kernel.
+//   const char *sampler_kernel(void)
+//     -- Returns the name of the kernel in use ("avx2" or "scalar").
+
+
+// Inclusions
+
+#include "sampler.h"
+
+// Constants
+
+#define SAMPLER_CHUNK 1024      // Values drawn per kernel call
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAMPLER_X86
+#include <immintrin.h>
+#endif
+
+
+static uint64_t splitmix64(uint64_t *x)
+{
+  uint64_t z;
+
+  z = (*x += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+void sampler_seed(SAMPLER *g, uint64_t seed)
+{
+  int i,k;
+  uint64_t z;
+
+  for (i=0; i<SAMPLER_LANES; i++) {
+    for (k=0; k<4; k+=2) {
+      z = splitmix64(&seed);
+      g->lane[k][i] = (uint32_t)z;
+      g->lane[k+1][i] = (uint32_t)(z >> 32);
+    }
+  }
+  for (k=0; k<4; k+=2) {
+    z = splitmix64(&seed);
+    g->retry[k] = (uint32_t)z;
+    g->retry[k+1] = (uint32_t)(z >> 32);
+  }
+}
+
+
+// One step of a scalar xoshiro128+ generator
+
+static inline uint32_t rotl(uint32_t x, int k)
+{
+  return (x << k) | (x >> (32 - k));
+}
+
+static inline uint32_t next(uint32_t *s0, uint32_t *s1, uint32_t *s2,
+                            uint32_t *s3)
+{
+  uint32_t result = *s0 + *s3;
+  uint32_t t = *s1 << 9;
+
+  *s2 ^= *s0;
+  *s3 ^= *s1;
+  *s1 ^= *s2;
+  *s0 ^= *s3;
+  *s2 ^= t;
+  *s3 = rotl(*s3,11);
+  return result;
+}
+
+
+// Function to redraw a rejected value from the retry generator
+
+static uint32_t redraw(SAMPLER *g, uint32_t range, uint32_t threshold)
+{
+  uint64_t m;
+
+  do {
+    m = (uint64_t)next(&g->retry[0],&g->retry[1],&g->retry[2],
+		       &g->retry[3]) * range;
+  } while ((uint32_t)m<threshold);
+  return (uint32_t)(m >> 32);
+}
+
+
+// Scalar kernel: "groups" groups of SAMPLER_LANES draws; the high halves
+// of x*range go to hi[], the low halves to lo[]
+
+static void groups_scalar(SAMPLER *g, uint32_t *hi, uint32_t *lo,
+                          long groups, uint32_t range)
+{
+  long k;
+  int i;
+  uint64_t m;
+
+  for (k=0; k<groups; k++) {
+    for (i=0; i<SAMPLER_LANES; i++) {
+      m = (uint64_t)next(&g->lane[0][i],&g->lane[1][i],&g->lane[2][i],
+			 &g->lane[3][i]) * range;
+      hi[k*SAMPLER_LANES+i] = (uint32_t)(m >> 32);
+      lo[k*SAMPLER_LANES+i] = (uint32_t)m;
+    }
+  }
+}
+
+
+#ifdef SAMPLER_X86
+
+// AVX2 kernel: the same as groups_scalar(), eight lanes at a time
+
+__attribute__((target("avx2")))
+static void groups_avx2(SAMPLER *g, uint32_t *hiout, uint32_t *loout,
+                        long groups, uint32_t range)
+{
+  long k;
+  __m256i s0,s1,s2,s3,x,t,r,pe,po,hi,lo;
+
+  s0 = _mm256_loadu_si256((__m256i *)g->lane[0]);
+  s1 = _mm256_loadu_si256((__m256i *)g->lane[1]);
+  s2 = _mm256_loadu_si256((__m256i *)g->lane[2]);
+  s3 = _mm256_loadu_si256((__m256i *)g->lane[3]);
+  r = _mm256_set1_epi32((int)range);
+
+  for (k=0; k<groups; k++) {
+    x = _mm256_add_epi32(s0,s3);
+    t = _mm256_slli_epi32(s1,9);
+    s2 = _mm256_xor_si256(s2,s0);
+    s3 = _mm256_xor_si256(s3,s1);
+    s1 = _mm256_xor_si256(s1,s2);
+    s0 = _mm256_xor_si256(s0,s3);
+    s2 = _mm256_xor_si256(s2,t);
+    s3 = _mm256_or_si256(_mm256_slli_epi32(s3,11),_mm256_srli_epi32(s3,21));
+
+    // 32x32->64 products of the even and the odd lanes
+    pe = _mm256_mul_epu32(x,r);
+    po = _mm256_mul_epu32(_mm256_srli_epi64(x,32),r);
+    hi = _mm256_blend_epi32(_mm256_srli_epi64(pe,32),po,0xAA);
+    lo = _mm256_blend_epi32(pe,_mm256_slli_epi64(po,32),0xAA);
+    _mm256_storeu_si256((__m256i *)(hiout+k*SAMPLER_LANES),hi);
+    _mm256_storeu_si256((__m256i *)(loout+k*SAMPLER_LANES),lo);
+  }
+
+  _mm256_storeu_si256((__m256i *)g->lane[0],s0);
+  _mm256_storeu_si256((__m256i *)g->lane[1],s1);
+  _mm256_storeu_si256((__m256i *)g->lane[2],s2);
+  _mm256_storeu_si256((__m256i *)g->lane[3],s3);
+}
+
+static int has_avx2(void)
+{
+  static int result = -1;
+
+  if (result<0) {
+    __builtin_cpu_init();
+    result = __builtin_cpu_supports("avx2") ? 1 : 0;
+  }
+  return result;
+}
+
+#else
+
+static int has_avx2(void)
+{
+  return 0;
+}
+
+#endif
+
+
+const char *sampler_kernel(void)
+{
+  return has_avx2() ? "avx2" : "scalar";
+}
+
+
+void sampler_uniform(SAMPLER *g, uint32_t *out, long n, uint32_t range)
+{
+  long done,count,groups,i;
+  uint32_t threshold;
+  uint32_t hi[SAMPLER_CHUNK],lo[SAMPLER_CHUNK];
+
+  threshold = (uint32_t)(-range) % range;     // 2^32 mod range
+  for (done=0; done<n; done+=count) {
+    count = n - done;
+    if (count>SAMPLER_CHUNK) count = SAMPLER_CHUNK;
+    groups = (count + SAMPLER_LANES - 1)/SAMPLER_LANES;
+#ifdef SAMPLER_X86
+    if (has_avx2()) groups_avx2(g,hi,lo,groups,range);
+    else
+#endif
+      groups_scalar(g,hi,lo,groups,range);
+    for (i=0; i<count; i++) {
+      out[done+i] = (lo[i]<threshold) ? redraw(g,range,threshold) : hi[i];
+    }
+  }
+}
@@ -0,0 +1,19 @@
+// Header file for the block sampler of bounded random integers
+
+#ifndef _SAMPLER_H
+#define _SAMPLER_H
+
+#include <stdint.h>
+
+#define SAMPLER_LANES 8
+
+typedef struct {
+  uint32_t lane[4][SAMPLER_LANES];  // xoshiro128+ state of each lane
+  uint32_t retry[4];                // xoshiro128+ state for rejected draws
+} SAMPLER;
+
+void sampler_seed(SAMPLER *g, uint64_t seed);
+void sampler_uniform(SAMPLER *g, uint32_t *out, long n, uint32_t range);
+const char *sampler_kernel(void);
+
+#endif
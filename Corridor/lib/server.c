@@ -0,0 +1,314 @@
+// Functions to serve requests on a Unix domain socket with a pool of
+// worker processes
+//
+// The server forks the workers, which take the connections in turn, and
+// replaces any worker that exits.  A connection carries any number of
+// requests, one line each, and gets one reply per request, in order:
+//
+//   ok BYTES               followed by BYTES bytes of body, or
+//   error STATUS BYTES     followed by BYTES bytes of messages
+//
+// The body is collected in a temporary file before the reply is sent, so
+// that its size is known and a failed request never leaves half a body
+// on the connection.
+//
+// Function calls:
+//   int server_listen(const char *path)
+//     -- Creates the socket "path" and listens on it; a socket left there
+//        by a server that is gone is replaced.  Returns its descriptor, or
+//        -1 if it cannot be created or another server is listening on it.
+//   int server_run(int fd, const char *path, int workers,
+//                  SERVER_HANDLER handle, void *data)
+//     -- Forks "workers" processes that accept connections on fd and call
+//        handle(data,line,body) for every request (see server.h).  Returns
+//        on SIGINT or SIGTERM, after stopping the workers and removing the
+//        socket "path": 0, or 1 if the workers could not be started.
+
+
+// Inclusions
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "server.h"
+
+// Constants
+
+#define BUFFER (1 << 16)           // Bytes of body copied at once
+
+// Globals
+
+static volatile sig_atomic_t stop=0;
+
+
+// Function to write n bytes, retrying short writes
+
+static int write_all(int fd, const void *data, size_t n)
+{
+  const char *p=data;
+  ssize_t done;
+
+  while (n>0) {
+    done = write(fd,p,n);
+    if (done<0) {
+      if (errno==EINTR) continue;
+      return 1;
+    }
+    p += done;
+    n -= done;
+  }
+  return 0;
+}
+
+
+int server_listen(const char *path)
+{
+  struct sockaddr_un addr;
+  struct stat st;
+  int fd;
+
+  if (strlen(path)>=sizeof(addr.sun_path)) return -1;
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path,path);
+
+  // A socket nobody listens on is left by a server that is gone
+  if ((stat(path,&st)==0)&&S_ISSOCK(st.st_mode)) {
+    fd = socket(AF_UNIX,SOCK_STREAM,0);
+    if (fd<0) return -1;
+    if (connect(fd,(struct sockaddr *)&addr,sizeof(addr))==0) {
+      close(fd);
+      return -1;
+    }
+    close(fd);
+    unlink(path);
+  }
+
+  fd = socket(AF_UNIX,SOCK_STREAM,0);
+  if (fd<0) return -1;
+  if ((bind(fd,(struct sockaddr *)&addr,sizeof(addr))!=0)||
+      (listen(fd,SOMAXCONN)!=0)) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+
+// Function to send the reply to a request, with the body held in the file
+// "body"; returns 0, or 1 if the connection is lost
+
+static int send_reply(int conn, int status, int body)
+{
+  static char buf[BUFFER];
+  char header[64];
+  off_t size;
+  ssize_t n;
+
+  size = lseek(body,0,SEEK_END);
+  if ((size<0)||(lseek(body,0,SEEK_SET)<0)) {
+    size = 0;
+    if (status==0) status = 1;
+  }
+  if (status==0) sprintf(header,"ok %lld\n",(long long)size);
+  else sprintf(header,"error %d %lld\n",status,(long long)size);
+  if (write_all(conn,header,strlen(header))!=0) return 1;
+  while (size>0) {
+    n = read(body,buf,(size<BUFFER) ? (size_t)size : BUFFER);
+    if (n<0) {
+      if (errno==EINTR) continue;
+      return 1;
+    }
+    if (n==0) return 1;              // The peer counts on size bytes
+    if (write_all(conn,buf,n)!=0) return 1;
+    size -= n;
+  }
+  return 0;
+}
+
+
+// Function to handle one request; returns 0, or 1 if the connection is lost
+
+static int handle_request(int conn, char *line, SERVER_HANDLER handle,
+                          void *data)
+{
+  static const char message[]="cannot create a temporary file.\n";
+  FILE *body;
+  int status,result;
+
+  body = tmpfile();
+  if (body==NULL) {
+    char header[64];
+
+    sprintf(header,"error 1 %d\n",(int)strlen(message));
+    return write_all(conn,header,strlen(header)) ||
+           write_all(conn,message,strlen(message));
+  }
+  status = handle(data,line,fileno(body));
+  result = send_reply(conn,status,fileno(body));
+  fclose(body);
+  return result;
+}
+
+
+// Function run by each worker: takes connections and answers their
+// requests until it is stopped
+
+static void serve_connections(int fd, SERVER_HANDLER handle, void *data)
+{
+  static const char toolong[]="error 1 18\nrequest too long.\n";
+  static char line[SERVER_LINE+2];
+  FILE *in;
+  size_t len;
+  int conn;
+
+  for (;;) {
+    conn = accept(fd,NULL,NULL);
+    if (conn<0) {
+      if ((errno==EINTR)||(errno==ECONNABORTED)) continue;
+      perror("accept");
+      exit(1);
+    }
+    in = fdopen(conn,"r");
+    if (in==NULL) {
+      close(conn);
+      continue;
+    }
+    while (fgets(line,sizeof(line),in)!=NULL) {
+      len = strlen(line);
+      if ((line[len-1]!='\n')&&(len>SERVER_LINE)) {
+        write_all(conn,toolong,strlen(toolong));
+        break;
+      }
+      while ((len>0)&&((line[len-1]=='\n')||(line[len-1]=='\r')))
+        line[--len] = '\0';
+      if (handle_request(conn,line,handle,data)!=0) break;
+    }
+    fclose(in);
+  }
+}
+
+
+// Function to fork a worker; returns its process id, or -1.  It is called
+// with SIGINT, SIGTERM and SIGCHLD blocked, so a SIGTERM sent to the worker
+// stays pending until it has dropped the handlers of the server; "mask" is
+// the signal mask to restore in the worker
+
+static pid_t start_worker(int fd, SERVER_HANDLER handle, void *data,
+                          const sigset_t *mask)
+{
+  pid_t pid;
+
+  fflush(stdout);
+  fflush(stderr);
+  pid = fork();
+  if (pid==0) {
+    signal(SIGINT,SIG_DFL);
+    signal(SIGTERM,SIG_DFL);
+    signal(SIGCHLD,SIG_DFL);
+    signal(SIGPIPE,SIG_IGN);         // A client that hangs up is not fatal
+    sigprocmask(SIG_SETMASK,mask,NULL);
+    serve_connections(fd,handle,data);
+    exit(0);
+  }
+  return pid;
+}
+
+
+static void on_stop(int sig)
+{
+  stop = 1;
+}
+
+
+static void on_child(int sig)
+{
+}
+
+
+int server_run(int fd, const char *path, int workers, SERVER_HANDLER handle,
+               void *data)
+{
+  struct sigaction sa;
+  sigset_t block,old,waiting,sleeping;
+  pid_t *pid,done;
+  int i,status,result=0;
+
+  pid = malloc(sizeof(pid_t)*workers);
+  if (pid==NULL) return 1;
+  memset(&sa,0,sizeof(sa));
+  sigemptyset(&sa.sa_mask);
+  sa.sa_handler = on_stop;
+  sigaction(SIGINT,&sa,NULL);
+  sigaction(SIGTERM,&sa,NULL);
+  sa.sa_handler = on_child;          // Wakes sigsuspend() when a worker exits
+  sa.sa_flags = SA_NOCLDSTOP;
+  sigaction(SIGCHLD,&sa,NULL);
+
+  // The signals are only taken in sigsuspend() and sleep(), so none can
+  // come between a test of stop and the wait that follows it
+  sigemptyset(&block);
+  sigaddset(&block,SIGINT);
+  sigaddset(&block,SIGTERM);
+  sigaddset(&block,SIGCHLD);
+  sigprocmask(SIG_BLOCK,&block,&old);
+  waiting = old;
+  sigdelset(&waiting,SIGINT);
+  sigdelset(&waiting,SIGTERM);
+  sigdelset(&waiting,SIGCHLD);
+  sleeping = waiting;
+  sigaddset(&sleeping,SIGCHLD);
+
+  for (i=0; i<workers; i++) {
+    pid[i] = start_worker(fd,handle,data,&old);
+    if (pid[i]<0) {
+      result = 1;
+      stop = 1;
+    }
+  }
+
+  // Replace the workers that exit
+  while (!stop) {
+    done = waitpid(-1,&status,WNOHANG);
+    if (done==0) {
+      sigsuspend(&waiting);
+      continue;
+    }
+    if (done<0) {
+      if (errno==EINTR) continue;
+      break;
+    }
+    for (i=0; i<workers; i++) {
+      if (pid[i]!=done) continue;
+      pid[i] = -1;
+      if (!WIFEXITED(status)||(WEXITSTATUS(status)!=0)) {
+        sigprocmask(SIG_SETMASK,&sleeping,NULL);
+        sleep(1);                    // Cut short by SIGINT or SIGTERM
+        sigprocmask(SIG_BLOCK,&block,NULL);
+      }
+      if (stop) break;
+      fprintf(stderr,"worker %ld exited; starting another\n",(long)done);
+      pid[i] = start_worker(fd,handle,data,&old);
+    }
+  }
+
+  for (i=0; i<workers; i++) {
+    if (pid[i]>0) kill(pid[i],SIGTERM);
+  }
+  while ((wait(NULL)>0)||(errno==EINTR));
+  close(fd);
+  unlink(path);
+  free(pid);
+  signal(SIGCHLD,SIG_DFL);
+  sigprocmask(SIG_SETMASK,&old,NULL);
+  return result;
+}
@@ -0,0 +1,16 @@
+// Header file for the server of requests on a Unix domain socket
+
+#ifndef _SERVER_H
+#define _SERVER_H
+
+#define SERVER_LINE 10000          // Longest request line, in bytes
+
+// Handles the request "line" (without its newline): writes the body of
+// the reply to the descriptor "body" and returns 0, or an error status
+typedef int (*SERVER_HANDLER)(void *data, char *line, int body);
+
+int server_listen(const char *path);
+int server_run(int fd, const char *path, int workers, SERVER_HANDLER handle,
+               void *data);
+
+#endif
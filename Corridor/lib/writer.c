@@ -0,0 +1,468 @@
+// Functions to write files through a background thread
+//
+// The caller formats its output into buffers of WRITER_BUFFER bytes; full
+// buffers go to a queue that one writer thread drains with large write()
+// calls, so formatting the next part of a file (or the next file) goes on
+// while the previous part is being written.  At most WRITER_BUFFERS buffers
+// exist, so the caller waits whenever it gets that far ahead of the disk.
+// The writer thread can also compute the FNV-1a hash of a file, so that it
+// need not be read back to be hashed.  If the thread cannot be
+// started, buffers are written by the caller as they fill up.
+//
+// A writer may also go to a descriptor that is already open, such as
+// standard output, and may frame its file as a record of a stream: the
+// file is then kept in memory and written, when closed, after a line that
+// gives its length, so that a reader can split the stream into files
+// without parsing them.  A memory writer keeps its file in memory for the
+// caller, to be used in place of the formatted text.
+//
+// Function calls:
+//   WRITER *writer_open(const char *filename, int hash)
+//     -- Creates (or truncates) "filename" for writing; its hash is computed
+//        only if "hash" is 1.  Returns NULL if the file cannot be opened.
+//   WRITER *writer_fd(int fd, int hash, const char *frame)
+//     -- Writes to the open descriptor fd, which is not closed at the end.
+//        If frame is not NULL, the file is written as the line
+//        "frame bytes" followed by its bytes.
+//   WRITER *writer_memory(void)
+//     -- Returns a writer that only keeps the file in memory, or NULL.
+//   char *writer_detach(WRITER *w, size_t *length)
+//     -- Ends the memory writer w and returns its contents (to be freed by
+//        the caller), with their size in *length.
+//   void writer_printf(WRITER *w, const char *format, ...)
+//     -- Appends formatted text, as fprintf() does.
+//   void writer_write(WRITER *w, const char *data, size_t n)
+//     -- Appends n bytes.
+//   void writer_int(WRITER *w, long long value, char sep)
+//     -- Appends value in decimal, followed by the character sep unless
+//        sep is '\0'; much faster than writer_printf() for long lists.
+//   void writer_close(WRITER *w, unsigned long long *hash, long long *bytes)
+//     -- Queues the rest of the file and its closing, and returns at once;
+//        w may not be used afterwards.  When the file has been written,
+//        its FNV-1a 64-bit hash (if asked for by writer_open()) and size
+//        are stored in *hash and *bytes (either may be NULL).
+//   int writer_finish(void)
+//     -- Waits until all closed files are written and stops the thread.
+//        Returns 0 if every write succeeded.
+
+
+// Inclusions
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "writer.h"
+
+// Types
+
+struct WRITER {
+  int fd;
+  int hashing;             // 1 if the hash is computed
+  int closing;             // 1 if fd is closed at the end
+  char *frame;             // Frame line (without the length), or NULL
+  int growing;             // 1 if buf grows instead of being handed over
+  char *buf;               // Buffer being filled, or NULL
+  size_t len;              // Bytes in buf
+  size_t size;             // Capacity of buf
+  unsigned long long hash; // Computed by the writer thread
+  long long bytes;
+  unsigned long long *hashp;
+  long long *bytesp;
+};
+
+typedef struct {
+  WRITER *w;
+  char *buf;
+  size_t len;
+  int close;               // 1 if the file ends with this buffer
+  int owned;               // 1 if buf is freed, not returned to the pool
+  int counted;             // 0 for a frame line, which is not in the file
+} ENTRY;
+
+// Globals
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static pthread_t thread;
+static int running=0;      // 1 while the writer thread runs
+static int stopping=0;     // 1 when the thread should end once idle
+static int failed=0;       // 1 if a write failed
+static char *pool[WRITER_BUFFERS];   // Free buffers
+static int nfree=0,nbuffers=0;
+static ENTRY queue[WRITER_BUFFERS];  // Ring of full buffers
+static int head=0,count=0;
+
+
+// Function to write one buffer of a file and, at the end, close it
+
+static void write_entry(ENTRY *e)
+{
+  WRITER *w = e->w;
+  size_t k,done;
+  ssize_t n;
+  unsigned long long h = w->hash;
+
+  if (w->hashing&&e->counted) {
+    for (k=0; k<e->len; k++) {
+      h ^= (unsigned char)e->buf[k];
+      h *= 0x100000001b3ULL;
+    }
+  }
+  w->hash = h;
+  if (e->counted) w->bytes += e->len;
+
+  for (done=0; done<e->len; done+=n) {
+    n = write(w->fd,e->buf+done,e->len-done);
+    if (n<0) {
+      if (errno==EINTR) {
+        n = 0;
+        continue;
+      }
+      failed = 1;
+      break;
+    }
+  }
+  if (e->close) {
+    if (w->closing&&(close(w->fd)!=0)) failed = 1;
+    if (w->hashp!=NULL) *w->hashp = w->hash;
+    if (w->bytesp!=NULL) *w->bytesp = w->bytes;
+    free(w->frame);
+    free(w);
+  }
+}
+
+
+// The writer thread
+
+static void *writer_thread(void *arg)
+{
+  ENTRY e;
+
+  pthread_mutex_lock(&lock);
+  for (;;) {
+    while ((count==0)&&!stopping) pthread_cond_wait(&changed,&lock);
+    if (count==0) break;
+    e = queue[head];
+    pthread_mutex_unlock(&lock);
+
+    write_entry(&e);
+
+    pthread_mutex_lock(&lock);
+    head = (head+1)%WRITER_BUFFERS;
+    count--;
+    if (e.owned) free(e.buf);
+    else pool[nfree++] = e.buf;
+    pthread_cond_broadcast(&changed);
+  }
+  pthread_mutex_unlock(&lock);
+  return NULL;
+}
+
+
+// Function to get an empty buffer, waiting for the writer thread if all
+// of them are full
+
+static char *get_buffer(void)
+{
+  char *buf;
+
+  pthread_mutex_lock(&lock);
+  if ((nfree==0)&&(nbuffers<WRITER_BUFFERS)) {
+    buf = malloc(WRITER_BUFFER);
+    if (buf!=NULL) {
+      pool[nfree++] = buf;
+      nbuffers++;
+    }
+  }
+  while (nfree==0) {
+    if (nbuffers==0) {
+      fprintf(stderr,"Out of memory for output buffers\n");
+      exit(1);
+    }
+    pthread_cond_wait(&changed,&lock);
+  }
+  buf = pool[--nfree];
+  pthread_mutex_unlock(&lock);
+  return buf;
+}
+
+
+// Function to queue a buffer for the writer thread
+
+static void put_entry(WRITER *w, char *buf, size_t len, int close, int owned,
+                      int counted)
+{
+  ENTRY e;
+
+  e.w = w;
+  e.buf = buf;
+  e.len = len;
+  e.close = close;
+  e.owned = owned;
+  e.counted = counted;
+
+  pthread_mutex_lock(&lock);
+  if (!running) {
+    // No thread: write the buffer here
+    pthread_mutex_unlock(&lock);
+    write_entry(&e);
+    pthread_mutex_lock(&lock);
+    if (owned) free(buf);
+    else pool[nfree++] = buf;
+  } else {
+    while (count==WRITER_BUFFERS) pthread_cond_wait(&changed,&lock);
+    queue[(head+count)%WRITER_BUFFERS] = e;
+    count++;
+    pthread_cond_broadcast(&changed);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+
+// Function to hand the buffer of w to the writer thread
+
+static void put_buffer(WRITER *w, int close)
+{
+  char *buf;
+  size_t len;
+
+  if (w->buf==NULL) w->buf = get_buffer();
+  buf = w->buf;
+  len = w->len;
+  w->buf = NULL;
+  w->len = 0;
+  w->size = WRITER_BUFFER;
+  put_entry(w,buf,len,close,0,1);
+}
+
+
+// Function to queue a framed file: its frame line, then its one buffer
+
+static void put_frame(WRITER *w)
+{
+  char *line;
+  size_t n;
+
+  n = strlen(w->frame) + 24;
+  line = malloc(n);
+  if (line==NULL) {
+    fprintf(stderr,"Out of memory for output buffers\n");
+    exit(1);
+  }
+  snprintf(line,n,"%s %lu\n",w->frame,(unsigned long)w->len);
+  put_entry(w,line,strlen(line),0,1,0);
+  put_entry(w,w->buf,w->len,1,1,1);
+}
+
+
+// Function to set up a writer for the descriptor fd and start the thread
+
+static WRITER *start_writer(int fd, int hash, int closing)
+{
+  WRITER *w;
+
+  w = calloc(1,sizeof(WRITER));
+  if (w==NULL) return NULL;
+  w->fd = fd;
+  w->hashing = hash;
+  w->closing = closing;
+  w->size = WRITER_BUFFER;
+  w->hash = 0xcbf29ce484222325ULL;
+
+  pthread_mutex_lock(&lock);
+  if (!running) {
+    stopping = 0;
+    running = (pthread_create(&thread,NULL,writer_thread,NULL)==0);
+  }
+  pthread_mutex_unlock(&lock);
+  return w;
+}
+
+
+WRITER *writer_open(const char *filename, int hash)
+{
+  WRITER *w;
+  int fd;
+
+  fd = open(filename,O_WRONLY|O_CREAT|O_TRUNC,0666);
+  if (fd<0) return NULL;
+  w = start_writer(fd,hash,1);
+  if (w==NULL) close(fd);
+  return w;
+}
+
+
+WRITER *writer_fd(int fd, int hash, const char *frame)
+{
+  WRITER *w;
+
+  w = start_writer(fd,hash,0);
+  if ((w!=NULL)&&(frame!=NULL)) {
+    w->frame = strdup(frame);
+    w->growing = 1;
+    w->size = WRITER_BUFFER;
+    w->buf = malloc(w->size);
+    if ((w->frame==NULL)||(w->buf==NULL)) {
+      free(w->frame);
+      free(w->buf);
+      free(w);
+      return NULL;
+    }
+  }
+  return w;
+}
+
+
+WRITER *writer_memory(void)
+{
+  WRITER *w;
+
+  w = calloc(1,sizeof(WRITER));
+  if (w==NULL) return NULL;
+  w->fd = -1;
+  w->growing = 1;
+  w->size = WRITER_BUFFER;
+  w->buf = malloc(w->size);
+  if (w->buf==NULL) {
+    free(w);
+    return NULL;
+  }
+  return w;
+}
+
+
+char *writer_detach(WRITER *w, size_t *length)
+{
+  char *buf;
+
+  buf = w->buf;
+  *length = w->len;
+  free(w);
+  return buf;
+}
+
+
+// Function to make room for n more bytes in the buffer of w; a framed
+// or memory file grows its buffer instead of handing it over
+
+static char *reserve(WRITER *w, size_t n)
+{
+  char *buf;
+
+  if (w->growing) {
+    if (w->len+n>w->size) {
+      buf = realloc(w->buf,2*w->size+n);
+      if (buf==NULL) {
+        fprintf(stderr,"Out of memory for output buffers\n");
+        exit(1);
+      }
+      w->buf = buf;
+      w->size = 2*w->size + n;
+    }
+    return w->buf + w->len;
+  }
+  if ((w->buf!=NULL)&&(w->len+n>WRITER_BUFFER)) put_buffer(w,0);
+  if (w->buf==NULL) w->buf = get_buffer();
+  return w->buf + w->len;
+}
+
+
+void writer_printf(WRITER *w, const char *format, ...)
+{
+  va_list ap;
+  int n;
+  char *p;
+
+  p = reserve(w,4096);
+  va_start(ap,format);
+  n = vsnprintf(p,w->size-w->len,format,ap);
+  va_end(ap);
+  if ((n>=0)&&((size_t)n>=w->size-w->len)) {
+    // Too long for the rest of the buffer: format it on its own
+    p = malloc(n+1);
+    if (p==NULL) {
+      failed = 1;
+      return;
+    }
+    va_start(ap,format);
+    vsnprintf(p,n+1,format,ap);
+    va_end(ap);
+    writer_write(w,p,n);
+    free(p);
+    return;
+  }
+  if (n>0) w->len += n;
+}
+
+
+void writer_write(WRITER *w, const char *data, size_t n)
+{
+  size_t k;
+  char *p;
+
+  while (n>0) {
+    p = reserve(w,1);
+    k = w->size - w->len;
+    if (k>n) k = n;
+    memcpy(p,data,k);
+    w->len += k;
+    data += k;
+    n -= k;
+  }
+}
+
+
+void writer_int(WRITER *w, long long value, char sep)
+{
+  char digits[24];
+  char *p;
+  int k=0,neg;
+  unsigned long long v;
+
+  neg = (value<0);
+  v = neg ? 0ULL-(unsigned long long)value : (unsigned long long)value;
+  do {
+    digits[k++] = (char)('0' + v%10);
+    v /= 10;
+  } while (v>0);
+  p = reserve(w,k+2);
+  if (neg) *p++ = '-';
+  while (k>0) *p++ = digits[--k];
+  if (sep!='\0') *p++ = sep;
+  w->len = p - w->buf;
+}
+
+
+void writer_close(WRITER *w, unsigned long long *hash, long long *bytes)
+{
+  w->hashp = hash;
+  w->bytesp = bytes;
+  if (w->frame!=NULL) put_frame(w);
+  else put_buffer(w,1);
+}
+
+
+int writer_finish(void)
+{
+  int result;
+
+  pthread_mutex_lock(&lock);
+  if (running) {
+    stopping = 1;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+    pthread_join(thread,NULL);
+    pthread_mutex_lock(&lock);
+    running = 0;
+  }
+  result = failed;
+  failed = 0;
+  pthread_mutex_unlock(&lock);
+  return result;
+}
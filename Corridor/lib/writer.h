@@ -0,0 +1,23 @@
+// Header file for the asynchronous file writer
+
+#ifndef _WRITER_H
+#define _WRITER_H
+
+#include <stddef.h>
+
+#define WRITER_BUFFER  (1 << 22)   // Bytes per buffer
+#define WRITER_BUFFERS 4           // Buffers filled or being written at once
+
+typedef struct WRITER WRITER;
+
+WRITER *writer_open(const char *filename, int hash);
+WRITER *writer_fd(int fd, int hash, const char *frame);
+WRITER *writer_memory(void);
+char *writer_detach(WRITER *w, size_t *length);
+void writer_printf(WRITER *w, const char *format, ...);
+void writer_write(WRITER *w, const char *data, size_t n);
+void writer_int(WRITER *w, long long value, char sep);
+void writer_close(WRITER *w, unsigned long long *hash, long long *bytes);
+int writer_finish(void);
+
+#endif